@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,13 +9,45 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    catalog.cpp \
+    checkpoint.cpp \
+    concurrencycontroller.cpp \
+    contentstats.cpp \
+    directorywalker.cpp \
+    estimator.cpp \
+    exif.cpp \
+    exporter.cpp \
+    fileidentity.cpp \
+    formatsniffer.cpp \
     imageinfo.cpp \
+    indexclient.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    memorybudget.cpp \
+    resultstore.cpp \
+    resulttablemodel.cpp \
+    scanengine.cpp \
+    snapshot.cpp
 
 HEADERS += \
+    catalog.h \
+    checkpoint.h \
+    concurrencycontroller.h \
+    contentstats.h \
+    directorywalker.h \
+    estimator.h \
+    exif.h \
+    exporter.h \
+    fileidentity.h \
+    formatsniffer.h \
     imageinfo.h \
-    mainwindow.h
+    indexclient.h \
+    mainwindow.h \
+    memorybudget.h \
+    resultstore.h \
+    resulttablemodel.h \
+    scanengine.h \
+    snapshot.h
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
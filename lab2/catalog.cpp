@@ -0,0 +1,169 @@
+#include "catalog.h"
+#include <QDir>
+
+static QString folderPrefix(const QString &folder)
+{
+    QString prefix = QDir::cleanPath(folder);
+    if (!prefix.endsWith('/')) prefix += '/';
+    return prefix;
+}
+
+void Catalog::insert(const ImageInfo &info)
+{
+    m_entries.insert(info.filePath, info);
+}
+
+void Catalog::remove(const QString &path)
+{
+    m_entries.remove(path);
+}
+
+bool Catalog::contains(const QString &path) const
+{
+    return m_entries.contains(path);
+}
+
+ImageInfo Catalog::value(const QString &path) const
+{
+    return m_entries.value(path);
+}
+
+int Catalog::size() const
+{
+    return m_entries.size();
+}
+
+QVector<ImageInfo> Catalog::entriesUnder(const QString &folder) const
+{
+    const QString prefix = folderPrefix(folder);
+    QVector<ImageInfo> result;
+    for (auto it = m_entries.lowerBound(prefix); it != m_entries.end() && it.key().startsWith(prefix); ++it)
+        result.append(it.value());
+    return result;
+}
+
+QVector<ImageInfo> Catalog::entriesIn(const QString &folder) const
+{
+    const QString prefix = folderPrefix(folder);
+    QVector<ImageInfo> result;
+    for (auto it = m_entries.lowerBound(prefix); it != m_entries.end() && it.key().startsWith(prefix); ++it) {
+        if (it.key().indexOf('/', prefix.size()) < 0) result.append(it.value());
+    }
+    return result;
+}
+
+QVector<ImageInfo> Catalog::filter(const QString &folder, const QString &field, const QString &value) const
+{
+    const QString prefix = folderPrefix(folder);
+    QVector<ImageInfo> result;
+    for (auto it = m_entries.lowerBound(prefix); it != m_entries.end() && it.key().startsWith(prefix); ++it) {
+        if (fieldValue(it.value(), field).contains(value, Qt::CaseInsensitive)) result.append(it.value());
+    }
+    return result;
+}
+
+QJsonArray Catalog::aggregate(const QString &folder, const QString &field) const
+{
+    const QString prefix = folderPrefix(folder);
+    QMap<QString, QPair<qint64, qint64>> groups;   // значение -> (файлов, байт)
+    for (auto it = m_entries.lowerBound(prefix); it != m_entries.end() && it.key().startsWith(prefix); ++it) {
+        QPair<qint64, qint64> &g = groups[fieldValue(it.value(), field)];
+        g.first += 1;
+        g.second += it.value().bytes;
+    }
+
+    QJsonArray result;
+    for (auto it = groups.cbegin(); it != groups.cend(); ++it) {
+        QJsonObject group;
+        group["key"] = it.key();
+        group["count"] = it.value().first;
+        group["bytes"] = it.value().second;
+        result.append(group);
+    }
+    return result;
+}
+
+void Catalog::retainUnder(const QString &folder, const QSet<QString> &keep)
+{
+    const QString prefix = folderPrefix(folder);
+    auto it = m_entries.lowerBound(prefix);
+    while (it != m_entries.end() && it.key().startsWith(prefix)) {
+        if (keep.contains(it.key())) ++it;
+        else it = m_entries.erase(it);
+    }
+}
+
+QString Catalog::fieldValue(const ImageInfo &info, const QString &field)
+{
+    if (field == "name") return info.fileName;
+    if (field == "path") return info.filePath;
+    if (field == "size") return info.size;
+    if (field == "resolution") return info.resolution;
+    if (field == "depth") return info.colorDepth;
+    if (field == "compression") return info.compression;
+    if (field == "format") return info.format;
+    if (field == "info") return info.additionalInfo;
+    if (field == "camera") return info.exif.camera;
+    return QString();
+}
+
+QJsonObject Catalog::toJson(const ImageInfo &info)
+{
+    QJsonObject obj;
+    obj["path"] = info.filePath;
+    obj["name"] = info.fileName;
+    obj["size"] = info.size;
+    obj["resolution"] = info.resolution;
+    obj["depth"] = info.colorDepth;
+    obj["compression"] = info.compression;
+    obj["format"] = info.format;
+    obj["fileSize"] = info.fileSize;
+    obj["info"] = info.additionalInfo;
+    obj["bytes"] = info.bytes;
+    obj["modified"] = info.modifiedMs;
+    obj["width"] = info.width;
+    obj["height"] = info.height;
+    obj["camera"] = info.exif.camera;
+    obj["captured"] = info.exif.capturedMs;
+    obj["orientation"] = info.exif.orientation;
+    obj["gps"] = info.exif.hasGps;
+    return obj;
+}
+
+ImageInfo Catalog::fromJson(const QJsonObject &obj)
+{
+    ImageInfo info;
+    info.filePath = obj["path"].toString();
+    info.fileName = obj["name"].toString();
+    info.size = obj["size"].toString();
+    info.resolution = obj["resolution"].toString();
+    info.colorDepth = obj["depth"].toString();
+    info.compression = obj["compression"].toString();
+    info.format = obj["format"].toString();
+    info.fileSize = obj["fileSize"].toString();
+    info.additionalInfo = obj["info"].toString();
+    info.bytes = obj["bytes"].toInteger();
+    info.modifiedMs = obj["modified"].toInteger();
+    info.width = obj["width"].toInt();
+    info.height = obj["height"].toInt();
+    info.exif.camera = obj["camera"].toString();
+    info.exif.capturedMs = obj["captured"].toInteger();
+    info.exif.orientation = obj["orientation"].toInt();
+    info.exif.hasGps = obj["gps"].toBool();
+    return info;
+}
+
+QJsonArray Catalog::toJson(const QVector<ImageInfo> &infos)
+{
+    QJsonArray rows;
+    for (const ImageInfo &info : infos) rows.append(toJson(info));
+    return rows;
+}
+
+QVector<ImageInfo> Catalog::fromJson(const QJsonArray &rows)
+{
+    QVector<ImageInfo> infos;
+    infos.reserve(rows.size());
+    for (const QJsonValue &row : rows) infos.append(fromJson(row.toObject()));
+    return infos;
+}
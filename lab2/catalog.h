@@ -0,0 +1,38 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <QMap>
+#include <QSet>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "imageinfo.h"
+
+// Каталог метаданных, отсортированный по полному пути: выборка по папке —
+// это один проход по диапазону ключей с общим префиксом.
+class Catalog {
+public:
+    void insert(const ImageInfo &info);
+    void remove(const QString &path);
+    bool contains(const QString &path) const;
+    ImageInfo value(const QString &path) const;
+    int size() const;
+
+    QVector<ImageInfo> entriesUnder(const QString &folder) const;
+    QVector<ImageInfo> entriesIn(const QString &folder) const;
+    QVector<ImageInfo> filter(const QString &folder, const QString &field, const QString &value) const;
+    QJsonArray aggregate(const QString &folder, const QString &field) const;
+
+    // Удаляет записи внутри folder, которых нет в keep (файлы удалены с диска)
+    void retainUnder(const QString &folder, const QSet<QString> &keep);
+
+    static QString fieldValue(const ImageInfo &info, const QString &field);
+    static QJsonObject toJson(const ImageInfo &info);
+    static ImageInfo fromJson(const QJsonObject &obj);
+    static QJsonArray toJson(const QVector<ImageInfo> &infos);
+    static QVector<ImageInfo> fromJson(const QJsonArray &rows);
+
+private:
+    QMap<QString, ImageInfo> m_entries;
+};
+
+#endif // CATALOG_H
@@ -0,0 +1,150 @@
+#include "checkpoint.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+namespace {
+const quint32 kCheckpointMagic = 0x4C32434B;   // "L2CK"
+const quint32 kCheckpointVersion = 2;
+
+enum RecordType : quint8 {
+    ResultRecord = 1,
+    DirectoryRecord = 2
+};
+
+void writeInfo(QDataStream &out, const ImageInfo &info, bool contentStats)
+{
+    out << info.filePath << info.fileName << info.size << info.resolution << info.colorDepth
+        << info.compression << info.format << info.fileSize << info.additionalInfo
+        << info.bytes << info.modifiedMs << qint32(info.width) << qint32(info.height)
+        << info.exif.camera << info.exif.capturedMs << qint8(info.exif.orientation) << info.exif.hasGps;
+    if (!contentStats) return;
+
+    const ContentStats &c = info.content;
+    out << c.valid << c.meanLuma << c.contrast << qint32(c.dominantCount);
+    for (int k = 0; k < ContentStats::kDominant; ++k) out << quint32(c.dominant[k]);
+    out.writeRawData(reinterpret_cast<const char *>(c.histogram), ContentStats::kBins);
+}
+
+void readInfo(QDataStream &in, ImageInfo &info, bool contentStats)
+{
+    qint32 width = 0, height = 0;
+    qint8 orientation = 0;
+    in >> info.filePath >> info.fileName >> info.size >> info.resolution >> info.colorDepth
+        >> info.compression >> info.format >> info.fileSize >> info.additionalInfo
+        >> info.bytes >> info.modifiedMs >> width >> height
+        >> info.exif.camera >> info.exif.capturedMs >> orientation >> info.exif.hasGps;
+    info.width = width;
+    info.height = height;
+    info.exif.orientation = orientation;
+    if (!contentStats) return;
+
+    ContentStats &c = info.content;
+    qint32 count = 0;
+    in >> c.valid >> c.meanLuma >> c.contrast >> count;
+    c.dominantCount = qBound(0, int(count), int(ContentStats::kDominant));
+    for (int k = 0; k < ContentStats::kDominant; ++k) {
+        quint32 color = 0;
+        in >> color;
+        c.dominant[k] = color;
+    }
+    if (in.readRawData(reinterpret_cast<char *>(c.histogram), ContentStats::kBins) != ContentStats::kBins)
+        in.setStatus(QDataStream::ReadPastEnd);
+}
+}
+
+QString ScanCheckpoint::fileFor(const QString &root)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/checkpoints";
+    const QByteArray key = QCryptographicHash::hash(QDir::cleanPath(root).toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir + '/' + QString::fromLatin1(key) + ".l2ckpt";
+}
+
+bool ScanCheckpoint::load(const QString &root, bool contentStats, CheckpointState *state)
+{
+    *state = CheckpointState();
+    QFile file(fileFor(root));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    QString savedRoot;
+    bool savedContent = false;
+    in >> magic >> version >> savedRoot >> savedContent;
+    if (in.status() != QDataStream::Ok || magic != kCheckpointMagic || version != kCheckpointVersion
+        || savedRoot != QDir::cleanPath(root) || savedContent != contentStats)
+        return false;
+
+    m_validSize = file.pos();
+    while (!in.atEnd()) {
+        quint8 type = 0;
+        in >> type;
+        if (type == ResultRecord) {
+            ImageInfo info;
+            readInfo(in, info, contentStats);
+            if (in.status() != QDataStream::Ok) break;
+            state->results.append(info);
+        } else if (type == DirectoryRecord) {
+            QString dir;
+            in >> dir;
+            if (in.status() != QDataStream::Ok) break;
+            state->completedDirs.insert(dir);
+        } else {
+            break;
+        }
+        m_validSize = file.pos();
+    }
+    return true;
+}
+
+bool ScanCheckpoint::open(const QString &root, bool contentStats, bool resume)
+{
+    close();
+    const QString fileName = fileFor(root);
+    QDir().mkpath(QFileInfo(fileName).path());
+    m_file.setFileName(fileName);
+
+    m_contentStats = contentStats;
+    if (resume) {
+        if (!m_file.open(QIODevice::ReadWrite)) return false;
+        // Хвост с оборванной записью отрезаем, иначе за ним потеряются новые
+        m_file.resize(m_validSize);
+        m_file.seek(m_validSize);
+        m_stream.setDevice(&m_file);
+        m_stream.setVersion(QDataStream::Qt_6_0);
+        return true;
+    }
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_0);
+    m_stream << kCheckpointMagic << kCheckpointVersion << QDir::cleanPath(root) << contentStats;
+    return m_stream.status() == QDataStream::Ok;
+}
+
+void ScanCheckpoint::write(const QVector<ImageInfo> &results, const QStringList &completedDirs)
+{
+    if (!m_file.isOpen() || (results.isEmpty() && completedDirs.isEmpty())) return;
+
+    // Сначала результаты, потом папки: папка в журнале — значит, все её файлы уже там
+    for (const ImageInfo &info : results) {
+        m_stream << quint8(ResultRecord);
+        writeInfo(m_stream, info, m_contentStats);
+    }
+    for (const QString &dir : completedDirs) m_stream << quint8(DirectoryRecord) << dir;
+    m_file.flush();
+}
+
+void ScanCheckpoint::close()
+{
+    m_stream.setDevice(nullptr);
+    m_file.close();
+}
+
+void ScanCheckpoint::remove()
+{
+    close();
+    QFile::remove(m_file.fileName());
+}
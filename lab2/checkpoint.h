@@ -0,0 +1,41 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QFile>
+#include <QDataStream>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include "imageinfo.h"
+
+// Журнал прерываемого сканирования: файл дописывается по ходу работы
+// записями "результат файла" и "папка обработана целиком". При повторном
+// сканировании той же папки результаты восстанавливаются из журнала, а
+// готовые папки не обходятся. Оборванная при аварии последняя запись
+// отбрасывается при чтении.
+struct CheckpointState {
+    QVector<ImageInfo> results;
+    QSet<QString> completedDirs;
+};
+
+class ScanCheckpoint {
+public:
+    static QString fileFor(const QString &root);
+
+    // false — журнала нет или он от другого режима сканирования
+    bool load(const QString &root, bool contentStats, CheckpointState *state);
+    // Начинает новый журнал или продолжает загруженный
+    bool open(const QString &root, bool contentStats, bool resume);
+    bool isOpen() const { return m_file.isOpen(); }
+    void write(const QVector<ImageInfo> &results, const QStringList &completedDirs);
+    void close();
+    void remove();
+
+private:
+    QFile m_file;
+    QDataStream m_stream;
+    qint64 m_validSize = 0;        // конец последней целой записи
+    bool m_contentStats = false;
+};
+
+#endif // CHECKPOINT_H
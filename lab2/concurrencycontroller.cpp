@@ -0,0 +1,67 @@
+#include "concurrencycontroller.h"
+
+namespace {
+const double kTolerance = 0.05;      // изменения меньше 5% считаем шумом
+const double kStarvedRatio = 0.5;    // потоки больше половины времени ждут входные данные
+const qint64 kMinCompletions = 8;    // меньше файлов за окно — замер слишком шумный
+const qint64 kMaxWindowNs = 2000000000LL;
+const int kProbeTicks = 8;           // после стольких замеров на плато пробуем добавить поток
+}
+
+ConcurrencyController::ConcurrencyController(int minWorkers, int maxWorkers, int initialWorkers)
+    : m_min(qMax(1, minWorkers)),
+      m_max(qMax(m_min, maxWorkers)),
+      m_limit(qBound(m_min, initialWorkers, m_max)),
+      m_completions(0),
+      m_waitNs(0),
+      m_windowNs(0),
+      m_direction(1),
+      m_holdTicks(0),
+      m_lastThroughput(-1.0),
+      m_lastStarvation(0.0) {}
+
+int ConcurrencyController::adjust(qint64 intervalNs)
+{
+    const int current = limit();
+    m_windowNs += intervalNs;
+    if (m_windowNs <= 0) return current;
+
+    // Медленную стадию (большие TIFF) оцениваем по более длинному окну
+    if (m_completions.load(std::memory_order_relaxed) < kMinCompletions && m_windowNs < kMaxWindowNs)
+        return current;
+
+    const qint64 done = m_completions.exchange(0);
+    const qint64 waitNs = m_waitNs.exchange(0);
+    const double window = double(m_windowNs);
+    m_windowNs = 0;
+
+    const double throughput = done * 1e9 / window;
+    const double starvation = waitNs / (window * current);
+
+    int step = 0;
+    if (starvation > kStarvedRatio) {
+        // Потоки простаивают: узкое место раньше по конвейеру, лишние потоки не нужны
+        step = -1;
+    } else if (m_lastThroughput < 0) {
+        step = 1;
+    } else if (throughput > m_lastThroughput * (1.0 + kTolerance)) {
+        step = m_direction;
+    } else if (throughput < m_lastThroughput * (1.0 - kTolerance)) {
+        step = -m_direction;
+    } else if (++m_holdTicks >= kProbeTicks) {
+        step = 1;
+    }
+
+    int next = current;
+    if (step != 0) {
+        m_holdTicks = 0;
+        next = qBound(m_min, current + step, m_max);
+        // Упёрлись в границу — следующий шаг делаем в обратную сторону
+        m_direction = (next == current) ? -step : step;
+    }
+
+    m_lastThroughput = throughput;
+    m_lastStarvation = starvation;
+    m_limit.store(next, std::memory_order_relaxed);
+    return next;
+}
@@ -0,0 +1,40 @@
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Подбор числа потоков одной стадии сканирования методом "восхождения на холм".
+// Рабочие потоки сообщают о каждом обработанном файле и о времени ожидания
+// входной очереди; раз в интервал adjust() сравнивает пропускную способность
+// с предыдущим замером и сдвигает лимит потоков на один шаг.
+class ConcurrencyController {
+public:
+    ConcurrencyController(int minWorkers, int maxWorkers, int initialWorkers);
+
+    int limit() const { return m_limit.load(std::memory_order_relaxed); }
+    int maxWorkers() const { return m_max; }
+    double throughput() const { return m_lastThroughput; }
+    double starvation() const { return m_lastStarvation; }
+
+    void recordCompletion() { m_completions.fetch_add(1, std::memory_order_relaxed); }
+    void recordWait(qint64 ns) { m_waitNs.fetch_add(ns, std::memory_order_relaxed); }
+
+    // Вызывается одним управляющим потоком; возвращает новый лимит.
+    int adjust(qint64 intervalNs);
+
+private:
+    int m_min;
+    int m_max;
+    std::atomic<int> m_limit;
+    std::atomic<qint64> m_completions;
+    std::atomic<qint64> m_waitNs;
+    qint64 m_windowNs;
+
+    int m_direction;
+    int m_holdTicks;
+    double m_lastThroughput;
+    double m_lastStarvation;
+};
+
+#endif // CONCURRENCYCONTROLLER_H
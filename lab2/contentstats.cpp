@@ -0,0 +1,161 @@
+#include "contentstats.h"
+#include <QColor>
+#include <QStringList>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONTENTSTATS_SSE2
+#endif
+
+namespace {
+const int kScale = 8;
+const int kChunk = 4096;     // столько пикселей суммируется в 32-битных полосах без переполнения
+const int kColorBits = 3;    // квантование цвета для поиска доминирующих: 3 бита на канал
+
+// Яркость по BT.601 в целых: (77 R + 150 G + 29 B) >> 8
+void lumaRow(const QRgb *src, quint8 *dst, int n)
+{
+    int x = 0;
+#ifdef CONTENTSTATS_SSE2
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i kr = _mm_set1_epi32(77);
+    const __m128i kg = _mm_set1_epi32(150);
+    const __m128i kb = _mm_set1_epi32(29);
+    auto luma4 = [&](__m128i v) {
+        // Каналы в младших 16 битах 32-битных полос; сумма произведений < 65536
+        __m128i b = _mm_and_si128(v, mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), mask);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), mask);
+        __m128i y = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, kr), _mm_mullo_epi16(g, kg)),
+                                  _mm_mullo_epi16(b, kb));
+        return _mm_srli_epi32(y, 8);
+    };
+    for (; x + 8 <= n; x += 8) {
+        __m128i y0 = luma4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x)));
+        __m128i y1 = luma4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 4)));
+        __m128i y16 = _mm_packs_epi32(y0, y1);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(y16, y16));
+    }
+#endif
+    for (; x < n; ++x) {
+        const QRgb p = src[x];
+        dst[x] = quint8((77 * qRed(p) + 150 * qGreen(p) + 29 * qBlue(p)) >> 8);
+    }
+}
+
+// Сумма и сумма квадратов яркостей
+void sumLuma(const quint8 *y, int n, quint64 *sum, quint64 *sumSq)
+{
+    int x = 0;
+#ifdef CONTENTSTATS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    while (x + 16 <= n) {
+        const int end = std::min(n, x + kChunk) & ~15;
+        __m128i s = zero;
+        __m128i sq = zero;
+        for (; x + 16 <= end; x += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+            s = _mm_add_epi64(s, _mm_sad_epu8(v, zero));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            sq = _mm_add_epi32(sq, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        }
+        alignas(16) quint64 s64[2];
+        alignas(16) quint32 sq32[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(s64), s);
+        _mm_store_si128(reinterpret_cast<__m128i *>(sq32), sq);
+        *sum += s64[0] + s64[1];
+        *sumSq += quint64(sq32[0]) + sq32[1] + sq32[2] + sq32[3];
+    }
+#endif
+    for (; x < n; ++x) {
+        *sum += y[x];
+        *sumSq += quint32(y[x]) * y[x];
+    }
+}
+}
+
+bool computeContentStats(const QImage &source, ContentStats *stats)
+{
+    *stats = ContentStats();
+    if (source.isNull()) return false;
+
+    // Для статистики достаточно выборки каждого 8-го пикселя, сглаживание не нужно
+    const QImage image = source.scaled(qMax(1, source.width() / kScale), qMax(1, source.height() / kScale),
+                                       Qt::IgnoreAspectRatio, Qt::FastTransformation)
+                             .convertToFormat(QImage::Format_RGB32);
+
+    const int w = image.width();
+    const int h = image.height();
+    QVector<quint8> luma(w);
+    quint64 counts[ContentStats::kBins] = {};
+    quint64 sum = 0;
+    quint64 sumSq = 0;
+
+    const int colorBins = 1 << (3 * kColorBits);
+    QVector<quint32> colorCount(colorBins, 0);
+    QVector<quint64> colorSum(colorBins * 3, 0);
+
+    for (int yy = 0; yy < h; ++yy) {
+        const QRgb *row = reinterpret_cast<const QRgb *>(image.constScanLine(yy));
+        lumaRow(row, luma.data(), w);
+        sumLuma(luma.constData(), w, &sum, &sumSq);
+        for (int x = 0; x < w; ++x) ++counts[luma[x] >> 4];
+
+        for (int x = 0; x < w; ++x) {
+            const QRgb p = row[x];
+            const int shift = 8 - kColorBits;
+            const int bin = ((qRed(p) >> shift) << (2 * kColorBits)) | ((qGreen(p) >> shift) << kColorBits)
+                            | (qBlue(p) >> shift);
+            ++colorCount[bin];
+            colorSum[bin * 3] += qRed(p);
+            colorSum[bin * 3 + 1] += qGreen(p);
+            colorSum[bin * 3 + 2] += qBlue(p);
+        }
+    }
+
+    const double n = double(w) * h;
+    const double mean = sum / n;
+    stats->meanLuma = float(mean);
+    stats->contrast = float(std::sqrt(qMax(0.0, sumSq / n - mean * mean)));
+
+    const quint64 peak = *std::max_element(counts, counts + ContentStats::kBins);
+    for (int i = 0; i < ContentStats::kBins; ++i)
+        stats->histogram[i] = quint8(peak ? (counts[i] * 255 + peak / 2) / peak : 0);
+
+    // Доминирующие цвета: самые заполненные корзины, цвет — среднее по корзине
+    QVector<int> order(colorBins);
+    for (int i = 0; i < colorBins; ++i) order[i] = i;
+    const int top = qMin(int(ContentStats::kDominant), colorBins);
+    std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                      [&](int a, int b) { return colorCount[a] > colorCount[b]; });
+    for (int i = 0; i < top && colorCount[order[i]] > 0; ++i) {
+        const int bin = order[i];
+        const quint64 c = colorCount[bin];
+        stats->dominant[i] = qRgb(int(colorSum[bin * 3] / c), int(colorSum[bin * 3 + 1] / c),
+                                  int(colorSum[bin * 3 + 2] / c));
+        stats->dominantCount = i + 1;
+    }
+
+    stats->valid = true;
+    return true;
+}
+
+QString dominantColorsText(const QRgb *colors, int count)
+{
+    QStringList names;
+    for (int i = 0; i < count; ++i) names << QColor(colors[i]).name();
+    return names.join(' ');
+}
+
+QString histogramText(const quint8 *bins)
+{
+    static const QString levels = QString::fromUtf8("▁▂▃▄▅▆▇█");
+    QString text;
+    text.reserve(ContentStats::kBins);
+    for (int i = 0; i < ContentStats::kBins; ++i) text += levels[qMin(7, bins[i] / 32)];
+    return text;
+}
@@ -0,0 +1,34 @@
+#ifndef CONTENTSTATS_H
+#define CONTENTSTATS_H
+
+#include <QImage>
+#include <QRgb>
+#include <QString>
+
+// Статистика содержимого по уменьшенной копии уже полностью декодированного
+// изображения: хватает, чтобы найти тёмные, пересвеченные и пустые (однотонные) сканы.
+struct ContentStats {
+    static constexpr int kBins = 16;
+    static constexpr int kDominant = 3;
+    static constexpr float kDarkLuma = 40;        // ниже — недоэкспонированный снимок
+    static constexpr float kBlankContrast = 4;    // ниже — пустой (однотонный) скан
+
+    bool valid = false;
+    float meanLuma = 0;                 // средняя яркость, 0..255
+    float contrast = 0;                 // СКО яркости
+    QRgb dominant[kDominant] = {};      // самые частые цвета по убыванию
+    int dominantCount = 0;
+    quint8 histogram[kBins] = {};       // доля пикселей в корзине, 0..255 от максимума
+
+    bool isUnderExposed() const { return valid && meanLuma < kDarkLuma; }
+    bool isBlank() const { return valid && contrast < kBlankContrast; }
+};
+
+// Считает статистику по копии уже декодированного изображения в масштабе 1/8:
+// второго декодирования файла ради статистики нет
+bool computeContentStats(const QImage &image, ContentStats *stats);
+
+QString dominantColorsText(const QRgb *colors, int count);
+QString histogramText(const quint8 *bins);
+
+#endif // CONTENTSTATS_H
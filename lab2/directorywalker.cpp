@@ -0,0 +1,98 @@
+#include "directorywalker.h"
+#include <QDirIterator>
+
+DirectoryWalker::DirectoryWalker(const QStringList &nameFilters, bool followSymlinks)
+    : m_nameFilters(nameFilters), m_followSymlinks(followSymlinks) {}
+
+void DirectoryWalker::setDirectoryHooks(const DirectoryHook &enter, const DirectoryHook &leave)
+{
+    m_enter = enter;
+    m_leave = leave;
+}
+
+void DirectoryWalker::setIdentityFilter(const IdentityFilter &filter)
+{
+    m_identityFilter = filter;
+}
+
+void DirectoryWalker::walk(const QString &root, const Visitor &visit, const std::atomic<bool> &cancelled)
+{
+    m_files.clear();
+    m_visitedDirs.clear();
+    m_ancestors.clear();
+    m_stats = WalkStats();
+
+    FileId id;
+    if (fileIdentity(root, &id)) {
+        m_visitedDirs.insert(id);
+        m_ancestors.insert(id);
+    }
+    walkDirectory(root, visit, cancelled);
+}
+
+bool DirectoryWalker::walkDirectory(const QString &dir, const Visitor &visit, const std::atomic<bool> &cancelled)
+{
+    if (m_enter && !m_enter(dir)) return true;
+    const bool goOn = walkEntries(dir, visit, cancelled);
+    // Недообойдённая папка (отмена, лимит файлов) не считается пройденной
+    if (goOn && m_leave) m_leave(dir);
+    return goOn;
+}
+
+bool DirectoryWalker::walkEntries(const QString &dir, const Visitor &visit, const std::atomic<bool> &cancelled)
+{
+    QStringList subdirs;
+
+    // AllDirs — папки не отсекаются фильтром имён
+    QDirIterator it(dir, m_nameFilters, QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        if (cancelled) return false;
+        const QString path = it.next();
+        const QFileInfo fi = it.fileInfo();
+
+        if (fi.isDir()) {
+            if (!fi.isSymLink() || m_followSymlinks) subdirs.append(path);
+            continue;
+        }
+        if (fi.isSymLink() && !m_followSymlinks) continue;
+
+        WalkEntry entry;
+        entry.path = path;
+        entry.directory = dir;
+        entry.size = fi.size();
+        entry.index = m_stats.files;
+        FileId id;
+        if ((!m_identityFilter || m_identityFilter(fi)) && fileIdentity(path, &id)) {
+            entry.primary = m_files.value(id, -1);
+            if (entry.primary < 0) m_files.insert(id, entry.index);
+            entry.linked = id.links > 1;
+        }
+        ++m_stats.files;
+        if (entry.primary >= 0) ++m_stats.duplicates;
+        else ++m_stats.unique;
+
+        if (!visit(entry)) return false;
+    }
+
+    for (const QString &sub : subdirs) {
+        FileId id;
+        const bool known = fileIdentity(sub, &id);
+        if (known) {
+            if (m_ancestors.contains(id)) {
+                ++m_stats.symlinkLoops;
+                continue;
+            }
+            if (m_visitedDirs.contains(id)) {
+                ++m_stats.duplicateDirs;
+                continue;
+            }
+            m_visitedDirs.insert(id);
+            m_ancestors.insert(id);
+        }
+
+        const bool goOn = walkDirectory(sub, visit, cancelled);
+        if (known) m_ancestors.remove(id);
+        if (!goOn) return false;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include "fileidentity.h"
+
+struct WalkEntry {
+    QString path;
+    QString directory;        // папка в том виде, в каком она передана обработчикам папок
+    qint64 index = 0;         // порядковый номер уникального файла
+    qint64 size = 0;          // из QFileInfo итератора: на Windows — из записи каталога, на POSIX —
+                              // из stat(), сделанного заодно с проверкой типа; файл не открывается
+    qint64 primary = -1;      // >= 0 — тот же физический файл, что и ранее найденный с этим номером
+    bool linked = false;      // у файла несколько жёстких ссылок
+                              // (оба поля — только для файлов, прошедших фильтр идентичности)
+};
+
+struct WalkStats {
+    qint64 files = 0;         // все найденные пути
+    qint64 unique = 0;        // физически разные файлы
+    qint64 duplicates = 0;    // жёсткие и символические ссылки на уже найденные файлы
+    qint64 symlinkLoops = 0;  // ссылки на папку-предка
+    qint64 duplicateDirs = 0; // папки, уже пройденные по другому пути
+};
+
+// Рекурсивный обход с переходом по символическим ссылкам. Папки и файлы
+// опознаются по (устройство, inode): повторно найденный файл отдаётся
+// как ссылка на первый, а ссылка на папку-предка (цикл) или на уже
+// пройденную папку не обходится.
+class DirectoryWalker {
+public:
+    using Visitor = std::function<bool(const WalkEntry &entry)>;
+    // enter: false — не заходить в папку; leave вызывается после всех вложенных
+    using DirectoryHook = std::function<bool(const QString &dir)>;
+    // true — узнать идентичность файла (fileIdentity); остальные файлы
+    // считаются уникальными. По умолчанию — все файлы
+    using IdentityFilter = std::function<bool(const QFileInfo &file)>;
+
+    DirectoryWalker(const QStringList &nameFilters, bool followSymlinks = true);
+
+    void setDirectoryHooks(const DirectoryHook &enter, const DirectoryHook &leave);
+    void setIdentityFilter(const IdentityFilter &filter);
+    void walk(const QString &root, const Visitor &visit, const std::atomic<bool> &cancelled);
+    WalkStats stats() const { return m_stats; }
+
+private:
+    bool walkDirectory(const QString &dir, const Visitor &visit, const std::atomic<bool> &cancelled);
+    bool walkEntries(const QString &dir, const Visitor &visit, const std::atomic<bool> &cancelled);
+
+    QStringList m_nameFilters;
+    bool m_followSymlinks;
+    DirectoryHook m_enter;
+    DirectoryHook m_leave;
+    IdentityFilter m_identityFilter;
+    QHash<FileId, qint64> m_files;      // номер первого пути к файлу
+    QSet<FileId> m_visitedDirs;
+    QSet<FileId> m_ancestors;
+    WalkStats m_stats;
+};
+
+#endif // DIRECTORYWALKER_H
@@ -0,0 +1,211 @@
+#include "estimator.h"
+#include "directorywalker.h"
+#include "formatsniffer.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+const double kZ = 1.96;            // 95% доверительный интервал
+const qint64 kProgressStep = 10000;
+const QString kNotImage = "не изображение";
+
+// Интервал Уилсона для доли: корректен и при малых n, и при долях около 0 или 1
+EstimateInterval wilsonInterval(int k, int n)
+{
+    EstimateInterval r;
+    if (n == 0) return r;
+    const double p = double(k) / n;
+    const double z2 = kZ * kZ;
+    const double denom = 1.0 + z2 / n;
+    const double center = (p + z2 / (2.0 * n)) / denom;
+    const double half = kZ * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / denom;
+    r.value = p;
+    r.low = qMax(0.0, center - half);
+    r.high = qMin(1.0, center + half);
+    return r;
+}
+
+// Оценка суммы по генеральной совокупности N по выборке с поправкой на конечность совокупности
+EstimateInterval totalInterval(const QVector<double> &values, qint64 population)
+{
+    EstimateInterval r;
+    const int n = values.size();
+    if (n == 0) return r;
+
+    double mean = 0;
+    for (double v : values) mean += v;
+    mean /= n;
+
+    double var = 0;
+    for (double v : values) var += (v - mean) * (v - mean);
+    var = n > 1 ? var / (n - 1) : 0;
+
+    const double fpc = population > 1 ? std::sqrt(double(population - n) / (population - 1)) : 0;
+    const double half = kZ * population * std::sqrt(var / n) * fpc;
+    r.value = mean * population;
+    r.low = qMax(0.0, r.value - half);
+    r.high = r.value + half;
+    return r;
+}
+}
+
+ScanEstimator::ScanEstimator(QObject *parent)
+    : QObject(parent), m_thread(nullptr), m_cancelled(false), m_done(false), m_generation(0)
+{
+    qRegisterMetaType<ScanEstimate>("ScanEstimate");
+}
+
+ScanEstimator::~ScanEstimator()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+bool ScanEstimator::isRunning() const
+{
+    return m_thread && m_thread->isRunning();
+}
+
+void ScanEstimator::cancel()
+{
+    m_cancelled = true;
+}
+
+void ScanEstimator::start(const QString &folder, const ScanOptions &options, int sampleSize)
+{
+    if (isRunning()) return;
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_cancelled = false;
+    m_options = options;
+    m_estimate = ScanEstimate();
+    m_done = false;
+    m_thread = QThread::create([this, folder, sampleSize] { run(folder, sampleSize); });
+    // Как в ScanEngine: finished() — после выхода потока, чтобы обработчик
+    // мог сразу запустить сканирование. Отменённая оценка сигнала не даёт
+    const int generation = ++m_generation;
+    connect(m_thread, &QThread::finished, this, [this, generation] {
+        if (generation == m_generation && m_done) emit finished(m_estimate);
+    });
+    m_thread->start();
+}
+
+void ScanEstimator::run(const QString &folder, int sampleSize)
+{
+    QElapsedTimer timer;
+    timer.start();
+    ScanEstimate estimate;
+
+    // Алгоритм R: i-й файл заменяет случайный элемент выборки с вероятностью k/i
+    std::mt19937_64 rng(std::random_device{}());
+    QStringList reservoir;
+    reservoir.reserve(sampleSize);
+    qint64 seen = 0;
+    // Тот же обход, что и у полного сканирования: циклы ссылок не проходятся,
+    // а повторный путь к файлу сканирование не читает, только копирует строку
+    DirectoryWalker walker(m_options.detectByContent ? QStringList() : ScanEngine::nameFilters(),
+                           m_options.followSymlinks);
+    walker.setIdentityFilter(ScanEngine::needsIdentity);
+    walker.walk(folder, [&](const WalkEntry &entry) {
+        if (entry.primary >= 0) return true;
+        if (seen < sampleSize) {
+            reservoir.append(entry.path);
+        } else {
+            std::uniform_int_distribution<qint64> pick(0, seen);
+            qint64 j = pick(rng);
+            if (j < sampleSize) reservoir[int(j)] = entry.path;
+        }
+        ++seen;
+        if (seen % kProgressStep == 0) emit filesSeen(seen);
+        return true;
+    }, m_cancelled);
+    estimate.totalFiles = seen;
+    estimate.walkMs = timer.elapsed();
+
+    // Метаданные выборки извлекаем параллельно, замеряя время на файл. Файл
+    // читается и отбирается как при сканировании: не-изображение тоже стоит
+    // времени на проверку сигнатуры, но в таблицу не попадает
+    const int threads = qMax(1, QThread::idealThreadCount());
+    estimate.threads = threads;
+    const int n = reservoir.size();
+    QVector<ImageInfo> sample(n);
+    QVector<char> isImage(n, 0);
+    QVector<double> fileNs(n);
+    const QString *paths = reservoir.constData();
+    ImageInfo *infos = sample.data();
+    char *images = isImage.data();
+    double *times = fileNs.data();
+    std::atomic<int> next(0);
+    QVector<QThread*> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.append(QThread::create([&] {
+            QElapsedTimer fileTimer;
+            for (int i = next++; i < n && !m_cancelled; i = next++) {
+                fileTimer.start();
+                QFile file(paths[i]);
+                QByteArray data = file.open(QIODevice::ReadOnly) ? file.read(kSniffBytes) : QByteArray();
+                images[i] = !m_options.detectByContent || !formatForExtension(paths[i]).isEmpty()
+                            || !sniffImageFormat(data).isEmpty();
+                if (images[i]) {
+                    data += file.readAll();
+                    infos[i] = getImageInfo(paths[i], data, m_options.contentStats);
+                }
+                times[i] = double(fileTimer.nsecsElapsed());
+            }
+        }));
+        workers.last()->start();
+    }
+    for (QThread *w : workers) {
+        w->wait();
+        delete w;
+    }
+    if (m_cancelled) return;
+
+    estimate.sampled = n;
+
+    QMap<QString, int> formatCounts;
+    QVector<double> pixels;
+    pixels.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        if (!isImage[i]) {
+            formatCounts[kNotImage]++;
+            pixels.append(0);
+            continue;
+        }
+        const ImageInfo &info = sample[i];
+        formatCounts[info.format.isEmpty() ? "?" : info.format]++;
+        pixels.append(double(info.width) * info.height);
+        estimate.sample.append(info);
+    }
+    for (auto f = formatCounts.cbegin(); f != formatCounts.cend(); ++f) {
+        FormatShare share;
+        share.format = f.key();
+        share.sampled = f.value();
+        share.share = wilsonInterval(f.value(), estimate.sampled);
+        estimate.formats.append(share);
+    }
+    std::sort(estimate.formats.begin(), estimate.formats.end(),
+              [](const FormatShare &a, const FormatShare &b) { return a.sampled > b.sampled; });
+
+    estimate.totalPixels = totalInterval(pixels, estimate.totalFiles);
+
+    // Прогноз: обход каталогов уже измерен, извлечение делится на число потоков
+    EstimateInterval cpuNs = totalInterval(fileNs, estimate.totalFiles);
+    const double perThread = 1e6 * threads;
+    estimate.scanMs.value = estimate.walkMs + cpuNs.value / perThread;
+    estimate.scanMs.low = estimate.walkMs + cpuNs.low / perThread;
+    estimate.scanMs.high = estimate.walkMs + cpuNs.high / perThread;
+
+    estimate.elapsedMs = timer.elapsed();
+    m_estimate = estimate;
+    m_done = true;
+}
@@ -0,0 +1,71 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include "imageinfo.h"
+#include "scanengine.h"
+
+struct EstimateInterval {
+    double value = 0;
+    double low = 0;
+    double high = 0;
+};
+
+struct FormatShare {
+    QString format;
+    int sampled = 0;
+    EstimateInterval share;       // доля, 0..1
+};
+
+struct ScanEstimate {
+    qint64 totalFiles = 0;
+    int sampled = 0;
+    int threads = 0;
+    qint64 walkMs = 0;
+    qint64 elapsedMs = 0;
+    QVector<FormatShare> formats;
+    EstimateInterval totalPixels;
+    EstimateInterval scanMs;      // прогноз полного сканирования
+    QVector<ImageInfo> sample;
+};
+
+Q_DECLARE_METATYPE(ScanEstimate)
+
+// Быстрая оценка большой папки: при обходе каталогов выбирается равномерная
+// случайная выборка файлов (reservoir sampling), по ней параллельно извлекаются
+// метаданные, и результат экстраполируется на всю папку с 95% доверительными
+// интервалами. Обход и отбор файлов — те же, что у сканирования с теми же
+// ScanOptions: по сигнатуре или по расширению, повторные пути к одному файлу
+// не считаются.
+class ScanEstimator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScanEstimator(QObject *parent = nullptr);
+    ~ScanEstimator();
+
+    void start(const QString &folder, const ScanOptions &options, int sampleSize = 2000);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void filesSeen(qint64 count);
+    void finished(const ScanEstimate &estimate);
+
+private:
+    void run(const QString &folder, int sampleSize);
+
+    QThread *m_thread;
+    std::atomic<bool> m_cancelled;
+    ScanOptions m_options;
+
+    // Итог run(), отдаётся сигналом finished() после выхода потока
+    ScanEstimate m_estimate;
+    bool m_done;
+    int m_generation;                            // номер запуска, см. start()
+};
+
+#endif // ESTIMATOR_H
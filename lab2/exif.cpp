@@ -0,0 +1,231 @@
+#include "exif.h"
+#include <QDate>
+#include <QDateTime>
+#include <QTimeZone>
+#include <cstring>
+
+namespace {
+enum Tag : quint16 {
+    TagMake = 0x010F,
+    TagModel = 0x0110,
+    TagOrientation = 0x0112,
+    TagDateTime = 0x0132,
+    TagExifIfd = 0x8769,
+    TagGpsIfd = 0x8825,
+    TagDateTimeOriginal = 0x9003
+};
+
+enum Type : quint16 {
+    TypeAscii = 2,
+    TypeShort = 3,
+    TypeLong = 4
+};
+
+const int kEntrySize = 12;
+const int kMaxEntries = 512;      // защита от мусорного счётчика записей
+
+// Окно на данные TIFF-структуры внутри буфера файла; все смещения — от его начала
+class TiffView {
+public:
+    TiffView(const uchar *data, quint32 size) : m_data(data), m_size(size), m_le(true) {}
+
+    bool readHeader(quint32 *firstIfd)
+    {
+        if (m_size < 8) return false;
+        if (m_data[0] == 'I' && m_data[1] == 'I') m_le = true;
+        else if (m_data[0] == 'M' && m_data[1] == 'M') m_le = false;
+        else return false;
+        if (u16(2) != 42) return false;
+        *firstIfd = u32(4);
+        return true;
+    }
+
+    bool contains(quint32 offset, quint32 length) const
+    {
+        return offset <= m_size && length <= m_size - offset;
+    }
+
+    quint16 u16(quint32 at) const
+    {
+        const uchar *p = m_data + at;
+        return m_le ? quint16(p[0] | p[1] << 8) : quint16(p[0] << 8 | p[1]);
+    }
+
+    quint32 u32(quint32 at) const
+    {
+        const uchar *p = m_data + at;
+        return m_le ? quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24
+                    : quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | quint32(p[3]);
+    }
+
+    // Строковое значение записи: до 4 байт хранятся в самой записи
+    bool ascii(quint32 entry, const char **text, int *length) const
+    {
+        if (u16(entry + 2) != TypeAscii) return false;
+        const quint32 count = u32(entry + 4);
+        const quint32 at = count <= 4 ? entry + 8 : u32(entry + 8);
+        if (count == 0 || !contains(at, count)) return false;
+        const char *p = reinterpret_cast<const char *>(m_data + at);
+        int n = int(count);
+        while (n > 0 && (p[n - 1] == '\0' || p[n - 1] == ' ')) --n;
+        const void *nul = memchr(p, '\0', size_t(n));
+        if (nul) n = int(static_cast<const char *>(nul) - p);
+        *text = p;
+        *length = n;
+        return n > 0;
+    }
+
+    quint32 integer(quint32 entry) const
+    {
+        return u16(entry + 2) == TypeShort ? u16(entry + 8) : u32(entry + 8);
+    }
+
+    // Вызывает visit(tag, entry) для каждой записи каталога
+    template <typename Visit>
+    bool forEachEntry(quint32 ifd, Visit visit) const
+    {
+        if (!contains(ifd, 2)) return false;
+        const int count = qMin(int(u16(ifd)), kMaxEntries);
+        for (int i = 0; i < count; ++i) {
+            const quint32 entry = ifd + 2 + quint32(i) * kEntrySize;
+            if (!contains(entry, kEntrySize)) return false;
+            visit(u16(entry), entry);
+        }
+        return true;
+    }
+
+private:
+    const uchar *m_data;
+    quint32 m_size;
+    bool m_le;
+};
+
+int digits(const char *p, int n)
+{
+    int value = 0;
+    for (int i = 0; i < n; ++i) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+// "YYYY:MM:DD HH:MM:SS"
+qint64 parseExifDate(const char *p, int n)
+{
+    if (n < 19) return 0;
+    const QDate date(digits(p, 4), digits(p + 5, 2), digits(p + 8, 2));
+    const QTime time(digits(p + 11, 2), digits(p + 14, 2), digits(p + 17, 2));
+    if (!date.isValid() || !time.isValid()) return 0;
+    return QDateTime(date, time, QTimeZone::UTC).toMSecsSinceEpoch();
+}
+
+bool parseTiff(const uchar *data, quint32 size, ExifInfo *exif)
+{
+    TiffView tiff(data, size);
+    quint32 ifd0 = 0;
+    if (!tiff.readHeader(&ifd0)) return false;
+
+    const char *make = nullptr, *model = nullptr;
+    int makeLength = 0, modelLength = 0;
+    quint32 exifIfd = 0;
+    qint64 modified = 0;
+
+    bool ok = tiff.forEachEntry(ifd0, [&](quint16 tag, quint32 entry) {
+        const char *text = nullptr;
+        int length = 0;
+        switch (tag) {
+        case TagMake:
+            if (tiff.ascii(entry, &text, &length)) { make = text; makeLength = length; }
+            break;
+        case TagModel:
+            if (tiff.ascii(entry, &text, &length)) { model = text; modelLength = length; }
+            break;
+        case TagOrientation:
+            exif->orientation = int(tiff.integer(entry));
+            if (exif->orientation < 1 || exif->orientation > 8) exif->orientation = 0;
+            break;
+        case TagDateTime:
+            if (tiff.ascii(entry, &text, &length)) modified = parseExifDate(text, length);
+            break;
+        case TagExifIfd:
+            exifIfd = tiff.integer(entry);
+            break;
+        case TagGpsIfd:
+            exif->hasGps = tiff.integer(entry) != 0;
+            break;
+        }
+    });
+    if (!ok) return false;
+
+    if (exifIfd) {
+        tiff.forEachEntry(exifIfd, [&](quint16 tag, quint32 entry) {
+            const char *text = nullptr;
+            int length = 0;
+            if (tag == TagDateTimeOriginal && tiff.ascii(entry, &text, &length))
+                exif->capturedMs = parseExifDate(text, length);
+        });
+    }
+    if (exif->capturedMs == 0) exif->capturedMs = modified;
+
+    // Модель часто уже начинается с имени производителя ("Canon" + "Canon EOS 5D")
+    const QString modelName = QString::fromUtf8(model, modelLength);
+    const QString makeName = QString::fromUtf8(make, makeLength);
+    if (makeName.isEmpty() || modelName.startsWith(makeName, Qt::CaseInsensitive))
+        exif->camera = modelName;
+    else
+        exif->camera = modelName.isEmpty() ? makeName : makeName + ' ' + modelName;
+    return true;
+}
+}
+
+bool parseExif(const char *data, qsizetype size, ExifInfo *exif)
+{
+    *exif = ExifInfo();
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    if (size < 8) return false;
+
+    // TIFF: теги лежат в самом файле
+    if ((p[0] == 'I' && p[1] == 'I') || (p[0] == 'M' && p[1] == 'M'))
+        return parseTiff(p, quint32(qMin<qsizetype>(size, 0xFFFFFFFF)), exif);
+
+    if (p[0] != 0xFF || p[1] != 0xD8) return false;
+
+    // JPEG: идём по маркерам до APP1 "Exif\0\0", не дальше начала сжатых данных
+    qsizetype pos = 2;
+    while (pos + 4 <= size) {
+        if (p[pos] != 0xFF) return false;
+        const uchar marker = p[pos + 1];
+        if (marker == 0xFF) {
+            ++pos;
+            continue;
+        }
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) return false;
+
+        const int length = p[pos + 2] << 8 | p[pos + 3];
+        if (length < 2 || pos + 2 + length > size) return false;
+        if (marker == 0xE1 && length >= 8 && memcmp(p + pos + 4, "Exif\0\0", 6) == 0)
+            return parseTiff(p + pos + 10, quint32(length - 8), exif);
+        pos += 2 + length;
+    }
+    return false;
+}
+
+QString orientationText(int orientation)
+{
+    switch (orientation) {
+    case 1: return "Обычная";
+    case 2: return "Отражение по горизонтали";
+    case 3: return "Поворот 180°";
+    case 4: return "Отражение по вертикали";
+    case 5: return "Отражение, поворот 90°";
+    case 6: return "Поворот 90° по часовой";
+    case 7: return "Отражение, поворот 270°";
+    case 8: return "Поворот 90° против часовой";
+    }
+    return QString();
+}
@@ -0,0 +1,24 @@
+#ifndef EXIF_H
+#define EXIF_H
+
+#include <QString>
+
+// Поля EXIF, которые показываются в таблице
+struct ExifInfo {
+    QString camera;           // производитель и модель
+    qint64 capturedMs = 0;    // DateTimeOriginal как "настенное" время в UTC, 0 — нет
+    int orientation = 0;      // 1..8 по EXIF, 0 — тега нет
+    bool hasGps = false;
+
+    // Ориентации 5..8 — поворот на 90°: ширина и высота меняются местами
+    bool swapsDimensions() const { return orientation >= 5 && orientation <= 8; }
+};
+
+// Разбирает EXIF прямо в байтах файла, без копирования: сегмент APP1 у JPEG
+// или заголовок TIFF. Декодируются только нужные теги; строки создаются
+// лишь для них. false — EXIF не найден или повреждён.
+bool parseExif(const char *data, qsizetype size, ExifInfo *exif);
+
+QString orientationText(int orientation);
+
+#endif // EXIF_H
@@ -0,0 +1,414 @@
+#include "exporter.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QTimeZone>
+#include <QtEndian>
+#include <functional>
+
+namespace {
+const quint32 kColumnarMagic = 0x4C32434C;    // "L2CL"
+const quint32 kColumnarVersion = 1;
+const qsizetype kBufferBytes = 8 * 1024 * 1024;
+const int kProgressRows = 65536;
+
+QByteArray csvField(const QByteArray &value)
+{
+    if (value.indexOf(',') < 0 && value.indexOf('"') < 0 && value.indexOf('\n') < 0 && value.indexOf('\r') < 0)
+        return value;
+    QByteArray quoted = value;
+    quoted.replace("\"", "\"\"");
+    return '"' + quoted + '"';
+}
+
+QVector<QByteArray> csvDictionary(const StringDictionary &dict)
+{
+    QVector<QByteArray> values;
+    values.reserve(dict.size());
+    for (int code = 0; code < dict.size(); ++code) values.append(csvField(dict.value(quint32(code)).toUtf8()));
+    return values;
+}
+}
+
+// Буфер поверх QSaveFile: на диск уходят блоки по kBufferBytes,
+// файл появляется под своим именем только после успешного commit()
+class ResultExporter::Output {
+public:
+    explicit Output(const QString &fileName) : m_file(fileName), m_written(0), m_ok(true) { m_buffer.reserve(kBufferBytes); }
+
+    bool open() { return m_ok = m_file.open(QIODevice::WriteOnly); }
+    bool ok() const { return m_ok; }
+    QString errorString() const { return m_file.errorString(); }
+    qint64 written() const { return m_written + m_buffer.size(); }
+
+    bool commit()
+    {
+        flush();
+        return m_ok && m_file.commit();
+    }
+
+    void flush()
+    {
+        if (m_buffer.isEmpty()) return;
+        write(m_buffer.constData(), m_buffer.size());
+        m_buffer.clear();
+    }
+
+    void append(const char *data, qsizetype size)
+    {
+        if (m_buffer.size() + size > kBufferBytes) flush();
+        // Большие колонки пишутся напрямую, минуя буфер
+        if (size >= kBufferBytes) write(data, size);
+        else m_buffer.append(data, size);
+    }
+
+    void append(const QByteArray &data) { append(data.constData(), data.size()); }
+
+    template <typename T>
+    void appendValue(T value)
+    {
+        const T le = qToLittleEndian(value);
+        append(reinterpret_cast<const char *>(&le), sizeof(T));
+    }
+
+    template <typename T>
+    void appendArray(const T *values, qsizetype count)
+    {
+        if constexpr (Q_BYTE_ORDER == Q_LITTLE_ENDIAN || sizeof(T) == 1) {
+            append(reinterpret_cast<const char *>(values), count * qsizetype(sizeof(T)));
+        } else {
+            for (qsizetype i = 0; i < count; ++i) appendValue(values[i]);
+        }
+    }
+
+    void appendString(const QByteArray &utf8)
+    {
+        appendValue(quint32(utf8.size()));
+        append(utf8);
+    }
+
+    void cancel() { m_file.cancelWriting(); }
+
+private:
+    void write(const char *data, qsizetype size)
+    {
+        if (m_ok && m_file.write(data, size) != size) m_ok = false;
+        m_written += size;
+    }
+
+    QSaveFile m_file;
+    QByteArray m_buffer;
+    qint64 m_written;
+    bool m_ok;
+};
+
+ResultExporter::ResultExporter(QObject *parent)
+    : QObject(parent),
+      m_format(ExportFormat::Csv),
+      m_thread(nullptr),
+      m_cancelled(false),
+      m_ok(false),
+      m_written(0),
+      m_elapsedMs(0),
+      m_generation(0) {}
+
+ResultExporter::~ResultExporter()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+ExportFormat ResultExporter::formatForFile(const QString &fileName)
+{
+    return QFileInfo(fileName).suffix().compare("csv", Qt::CaseInsensitive) == 0 ? ExportFormat::Csv
+                                                                                 : ExportFormat::Columnar;
+}
+
+bool ResultExporter::isRunning() const
+{
+    return m_thread && m_thread->isRunning();
+}
+
+void ResultExporter::start(const ResultStore &store, const QString &fileName, ExportFormat format)
+{
+    if (isRunning()) return;
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+
+    m_store = store;
+    m_fileName = fileName;
+    m_format = format;
+    m_cancelled = false;
+    m_thread = QThread::create([this] { run(); });
+    // Как в ScanEngine: finished() — после выхода потока, чтобы обработчик
+    // мог сразу начать следующий экспорт
+    const int generation = ++m_generation;
+    connect(m_thread, &QThread::finished, this, [this, generation] {
+        if (generation == m_generation) emit finished(m_ok, m_error, m_written, m_elapsedMs);
+    });
+    m_thread->start();
+}
+
+void ResultExporter::cancel()
+{
+    m_cancelled = true;
+}
+
+void ResultExporter::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Output out(m_fileName);
+    QString error;
+    bool ok = out.open();
+    if (ok) ok = m_format == ExportFormat::Csv ? writeCsv(out) : writeColumnar(out);
+    if (ok && m_cancelled) {
+        error = "Экспорт отменён";
+        ok = false;
+    }
+    if (ok) ok = out.commit();
+    if (!ok) {
+        if (error.isEmpty()) error = out.errorString();
+        out.cancel();
+    }
+
+    // Копия хранилища больше не нужна — освобождаем память сразу
+    m_store = ResultStore();
+    m_ok = ok;
+    m_error = error;
+    m_written = out.written();
+    m_elapsedMs = timer.elapsed();
+}
+
+bool ResultExporter::writeCsv(Output &out)
+{
+    const ResultStore &s = m_store;
+    const QVector<QByteArray> strings = csvDictionary(s.strings());
+    const QVector<QByteArray> components = csvDictionary(s.paths().components());
+    QHash<quint32, QByteArray> folders;     // узел папки -> путь с '/' на конце
+
+    // Путь папки собирается один раз на папку, а не на каждый файл
+    std::function<QByteArray(quint32)> folderPath = [&](quint32 node) {
+        auto it = folders.constFind(node);
+        if (it != folders.constEnd()) return it.value();
+        QByteArray path;
+        if (node != PathTrie::kRoot)
+            path = folderPath(s.paths().parent(node)) + s.paths().name(node).toUtf8() + '/';
+        folders.insert(node, path);
+        return path;
+    };
+
+    QByteArray header = "\xEF\xBB\xBF"      // BOM: Excel иначе читает UTF-8 как ANSI
+                        "path,name,width,height,resolution,depth,compression,format,bytes,modified,info,"
+                        "camera,captured,orientation,gps";
+    if (s.hasContentStats()) header += ",mean_luma,contrast,dominant_colors,histogram";
+    header += "\r\n";
+    out.append(header);
+
+    QByteArray line;
+    for (int i = 0; i < s.size(); ++i) {
+        if (m_cancelled) return true;
+
+        const quint32 node = s.pathColumn()[i];
+        const quint32 name = s.paths().nameCode(node);
+        line.clear();
+        line += csvField(folderPath(s.paths().parent(node)) + s.paths().components().value(name).toUtf8());
+        line += ',';
+        line += components[int(name)];
+        line += ',';
+        line += QByteArray::number(s.width(i));
+        line += ',';
+        line += QByteArray::number(s.height(i));
+        line += ',';
+        line += strings[int(s.resolutionColumn()[i])];
+        line += ',';
+        line += strings[int(s.depthColumn()[i])];
+        line += ',';
+        line += strings[int(s.compressionColumn()[i])];
+        line += ',';
+        line += strings[int(s.formatColumn()[i])];
+        line += ',';
+        line += QByteArray::number(s.bytes(i));
+        line += ',';
+        if (s.modifiedMs(i) > 0)
+            line += QDateTime::fromMSecsSinceEpoch(s.modifiedMs(i), QTimeZone::UTC).toString(Qt::ISODate).toLatin1();
+        line += ',';
+        line += strings[int(s.infoColumn()[i])];
+        line += ',';
+        line += strings[int(s.cameraColumn()[i])];
+        line += ',';
+        if (s.capturedColumn()[i] != 0)
+            line += QDateTime::fromMSecsSinceEpoch(s.capturedColumn()[i], QTimeZone::UTC).toString("yyyy-MM-dd HH:mm:ss").toLatin1();
+        line += ',';
+        if (s.orientationColumn()[i]) line += QByteArray::number(s.orientationColumn()[i]);
+        line += ',';
+        line += s.gpsColumn()[i] ? '1' : '0';
+
+        if (s.hasContentStats()) {
+            if (s.contentValid(i)) {
+                line += ',';
+                line += QByteArray::number(s.meanLuma(i), 'f', 1);
+                line += ',';
+                line += QByteArray::number(s.contrast(i), 'f', 1);
+                line += ',';
+                const QRgb *colors = s.dominantColumn().constData() + qsizetype(i) * ContentStats::kDominant;
+                int count = 0;
+                while (count < ContentStats::kDominant && colors[count] != 0) ++count;
+                line += dominantColorsText(colors, count).toLatin1();
+                line += ',';
+                const quint8 *bins = s.histogramColumn().constData() + qsizetype(i) * ContentStats::kBins;
+                for (int k = 0; k < ContentStats::kBins; ++k) {
+                    if (k) line += ' ';
+                    line += QByteArray::number(bins[k]);
+                }
+            } else {
+                line += ",,,,";
+            }
+        }
+        line += "\r\n";
+        out.append(line);
+        if (!out.ok()) return false;
+
+        if ((i + 1) % kProgressRows == 0) emit progress(int(qint64(i + 1) * 100 / s.size()));
+    }
+    return true;
+}
+
+void ResultExporter::writeStringColumn(Output &out, const char *name, const QVector<quint32> &codes)
+{
+    // Словарь колонки — только встречающиеся в ней значения, коды перенумерованы
+    // плотно, чтобы уместиться в 1 или 2 байта
+    QVector<qint32> remap(m_store.strings().size(), -1);
+    QVector<quint32> values;
+    QVector<quint32> local(codes.size());
+    for (qsizetype i = 0; i < codes.size(); ++i) {
+        qint32 &code = remap[int(codes[i])];
+        if (code < 0) {
+            code = qint32(values.size());
+            values.append(codes[i]);
+        }
+        local[i] = quint32(code);
+    }
+
+    const QByteArray utf8Name(name);
+    out.appendValue(quint16(utf8Name.size()));
+    out.append(utf8Name);
+    out.appendValue(quint8(String));
+    out.appendValue(quint8(1));
+    out.appendValue(quint32(values.size()));
+    for (quint32 code : values) out.appendString(m_store.strings().value(code).toUtf8());
+
+    if (values.size() <= 0x100) {
+        QVector<quint8> narrow(local.size());
+        for (qsizetype i = 0; i < local.size(); ++i) narrow[i] = quint8(local[i]);
+        out.appendValue(quint8(1));
+        out.appendArray(narrow.constData(), narrow.size());
+    } else if (values.size() <= 0x10000) {
+        QVector<quint16> narrow(local.size());
+        for (qsizetype i = 0; i < local.size(); ++i) narrow[i] = quint16(local[i]);
+        out.appendValue(quint8(2));
+        out.appendArray(narrow.constData(), narrow.size());
+    } else {
+        out.appendValue(quint8(4));
+        out.appendArray(local.constData(), local.size());
+    }
+}
+
+bool ResultExporter::writeColumnar(Output &out)
+{
+    const ResultStore &s = m_store;
+    const int columns = s.hasContentStats() ? 18 : 14;
+    int done = 0;
+
+    auto columnHeader = [&](const char *name, ColumnType type, int width) {
+        const QByteArray utf8Name(name);
+        out.appendValue(quint16(utf8Name.size()));
+        out.append(utf8Name);
+        out.appendValue(quint8(type));
+        out.appendValue(quint8(width));
+    };
+    auto columnDone = [&] {
+        emit progress(++done * 100 / columns);
+        return out.ok() && !m_cancelled;
+    };
+
+    out.appendValue(kColumnarMagic);
+    out.appendValue(kColumnarVersion);
+    out.appendValue(quint64(s.size()));
+    out.appendValue(quint32(columns));
+
+    // Пути — тем же префиксным деревом, что и в памяти
+    columnHeader("path", Path, 1);
+    const StringDictionary &components = s.paths().components();
+    out.appendValue(quint32(components.size()));
+    for (int code = 0; code < components.size(); ++code) out.appendString(components.value(quint32(code)).toUtf8());
+    out.appendValue(quint32(s.paths().size()));
+    for (int node = 0; node < s.paths().size(); ++node) {
+        out.appendValue(s.paths().parent(quint32(node)));
+        out.appendValue(s.paths().nameCode(quint32(node)));
+    }
+    out.appendArray(s.pathColumn().constData(), s.pathColumn().size());
+    if (!columnDone()) return true;
+
+    columnHeader("width", Int32, 1);
+    out.appendArray(s.widthColumn().constData(), s.widthColumn().size());
+    if (!columnDone()) return true;
+    columnHeader("height", Int32, 1);
+    out.appendArray(s.heightColumn().constData(), s.heightColumn().size());
+    if (!columnDone()) return true;
+    columnHeader("bytes", Int64, 1);
+    out.appendArray(s.bytesColumn().constData(), s.bytesColumn().size());
+    if (!columnDone()) return true;
+    columnHeader("modified", Int64, 1);
+    out.appendArray(s.modifiedColumn().constData(), s.modifiedColumn().size());
+    if (!columnDone()) return true;
+
+    writeStringColumn(out, "resolution", s.resolutionColumn());
+    if (!columnDone()) return true;
+    writeStringColumn(out, "depth", s.depthColumn());
+    if (!columnDone()) return true;
+    writeStringColumn(out, "compression", s.compressionColumn());
+    if (!columnDone()) return true;
+    writeStringColumn(out, "format", s.formatColumn());
+    if (!columnDone()) return true;
+    writeStringColumn(out, "info", s.infoColumn());
+    if (!columnDone()) return true;
+
+    writeStringColumn(out, "camera", s.cameraColumn());
+    if (!columnDone()) return true;
+    columnHeader("captured", Int64, 1);
+    out.appendArray(s.capturedColumn().constData(), s.capturedColumn().size());
+    if (!columnDone()) return true;
+    columnHeader("orientation", UInt8, 1);
+    out.appendArray(s.orientationColumn().constData(), s.orientationColumn().size());
+    if (!columnDone()) return true;
+    columnHeader("gps", UInt8, 1);
+    out.appendArray(s.gpsColumn().constData(), s.gpsColumn().size());
+    if (!columnDone()) return true;
+
+    if (s.hasContentStats()) {
+        columnHeader("mean_luma", Float32, 1);
+        out.appendArray(s.lumaColumn().constData(), s.lumaColumn().size());
+        if (!columnDone()) return true;
+        columnHeader("contrast", Float32, 1);
+        out.appendArray(s.contrastColumn().constData(), s.contrastColumn().size());
+        if (!columnDone()) return true;
+        columnHeader("dominant_colors", UInt32, ContentStats::kDominant);
+        out.appendArray(s.dominantColumn().constData(), s.dominantColumn().size());
+        if (!columnDone()) return true;
+        columnHeader("histogram", UInt8, ContentStats::kBins);
+        out.appendArray(s.histogramColumn().constData(), s.histogramColumn().size());
+        if (!columnDone()) return true;
+    }
+
+    // Имя файла отдельной колонкой не пишется: это последний компонент пути
+    return out.ok();
+}
@@ -0,0 +1,75 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include "resultstore.h"
+
+enum class ExportFormat {
+    Csv,
+    Columnar
+};
+
+// Потоковый экспорт результатов из ResultStore в CSV или в колоночный
+// двоичный файл (*.l2col) на отдельном потоке. Запись идёт крупными блоками
+// через буфер, строки словарей кодируются один раз на значение, а не на строку.
+//
+// Формат *.l2col (все числа little-endian):
+//   u32 магия "L2CL", u32 версия, u64 строк, u32 колонок
+//   колонка: u16 длина + UTF-8 имя, u8 тип, u8 значений на строку, данные
+//     Int32/Int64/Float32/UInt32/UInt8 — строки подряд
+//     String — словарь (u32 число, далее u32 длина + UTF-8), u8 ширина кода (1/2/4), коды
+//     Path — словарь компонентов, u32 число узлов, узлы (u32 родитель, u32 компонент), u32 узел на строку
+class ResultExporter : public QObject
+{
+    Q_OBJECT
+public:
+    enum ColumnType : quint8 {
+        Int32 = 1,
+        Int64 = 2,
+        Float32 = 3,
+        UInt32 = 4,
+        UInt8 = 5,
+        String = 6,
+        Path = 7
+    };
+
+    explicit ResultExporter(QObject *parent = nullptr);
+    ~ResultExporter();
+
+    // Хранилище копируется (данные общие до первого изменения), поэтому
+    // новое сканирование во время экспорта ему не мешает
+    void start(const ResultStore &store, const QString &fileName, ExportFormat format);
+    void cancel();
+    bool isRunning() const;
+
+    static ExportFormat formatForFile(const QString &fileName);
+
+signals:
+    void progress(int percent);
+    void finished(bool ok, const QString &error, qint64 bytesWritten, qint64 elapsedMs);
+
+private:
+    class Output;
+
+    void run();
+    bool writeCsv(Output &out);
+    bool writeColumnar(Output &out);
+    void writeStringColumn(Output &out, const char *name, const QVector<quint32> &codes);
+
+    ResultStore m_store;
+    QString m_fileName;
+    ExportFormat m_format;
+    QThread *m_thread;
+    std::atomic<bool> m_cancelled;
+
+    // Итог run(), отдаётся сигналом finished() после выхода потока
+    bool m_ok;
+    QString m_error;
+    qint64 m_written;
+    qint64 m_elapsedMs;
+    int m_generation;                            // номер запуска, см. start()
+};
+
+#endif // EXPORTER_H
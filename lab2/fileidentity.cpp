@@ -0,0 +1,37 @@
+#include "fileidentity.h"
+#include <QDir>
+#include <QFile>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+bool fileIdentity(const QString &path, FileId *id)
+{
+#ifdef Q_OS_WIN
+    const QString native = QDir::toNativeSeparators(path);
+    // FILE_FLAG_BACKUP_SEMANTICS нужен, чтобы открыть папку
+    HANDLE h = CreateFileW(reinterpret_cast<const wchar_t *>(native.utf16()), 0,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(h, &info);
+    CloseHandle(h);
+    if (!ok) return false;
+    id->device = info.dwVolumeSerialNumber;
+    id->inode = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    id->links = info.nNumberOfLinks;
+    return true;
+#else
+    // stat() проходит по символическим ссылкам — получаем идентичность цели
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) return false;
+    id->device = quint64(st.st_dev);
+    id->inode = quint64(st.st_ino);
+    id->links = quint32(st.st_nlink);
+    return true;
+#endif
+}
@@ -0,0 +1,27 @@
+#ifndef FILEIDENTITY_H
+#define FILEIDENTITY_H
+
+#include <QHash>
+#include <QString>
+
+// Физическая идентичность файла: (устройство, inode) на Unix,
+// (серийный номер тома, индекс файла) на Windows. Жёсткие ссылки и
+// символические ссылки на один файл дают одинаковый FileId.
+struct FileId {
+    quint64 device = 0;
+    quint64 inode = 0;
+    quint32 links = 0;       // число жёстких ссылок
+
+    bool operator==(const FileId &other) const { return device == other.device && inode == other.inode; }
+};
+
+inline size_t qHash(const FileId &id, size_t seed = 0)
+{
+    return qHashMulti(seed, id.device, id.inode);
+}
+
+// На Windows — открытие файла (CreateFileW) и GetFileInformationByHandle,
+// поэтому вызывать только для файлов, где идентичность действительно нужна
+bool fileIdentity(const QString &path, FileId *id);
+
+#endif // FILEIDENTITY_H
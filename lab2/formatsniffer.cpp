@@ -0,0 +1,88 @@
+#include "formatsniffer.h"
+#include <QFileInfo>
+
+namespace {
+struct Signature {
+    const char *format;
+    int length;
+    unsigned char pattern[kSniffBytes];
+    unsigned char mask[kSniffBytes];     // 0xFF — байт должен совпасть, 0x00 — любой
+};
+
+// Порядок важен: сначала длинные сигнатуры, короткие и слабые (BMP, PCX) — в конце
+constexpr Signature kSignatures[] = {
+    {"png", 8, {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A},
+               {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+    {"gif", 6, {'G', 'I', 'F', '8', '7', 'a'},
+               {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+    {"gif", 6, {'G', 'I', 'F', '8', '9', 'a'},
+               {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+    {"tiff", 4, {'I', 'I', 0x2A, 0x00},
+                {0xFF, 0xFF, 0xFF, 0xFF}},
+    {"tiff", 4, {'M', 'M', 0x00, 0x2A},
+                {0xFF, 0xFF, 0xFF, 0xFF}},
+    {"jpeg", 3, {0xFF, 0xD8, 0xFF},
+                {0xFF, 0xFF, 0xFF}},
+    // "BM", размер файла, затем 4 зарезервированных нулевых байта
+    {"bmp", 10, {'B', 'M', 0, 0, 0, 0, 0, 0, 0, 0},
+                {0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF}},
+    // Маркер 0x0A, версия, кодирование RLE = 1
+    {"pcx", 3, {0x0A, 0x00, 0x01},
+               {0xFF, 0x00, 0xFF}},
+};
+
+constexpr bool matches(const Signature &sig, const unsigned char *data, qsizetype size)
+{
+    if (size < sig.length) return false;
+    for (int i = 0; i < sig.length; ++i) {
+        if ((data[i] & sig.mask[i]) != (sig.pattern[i] & sig.mask[i])) return false;
+    }
+    return true;
+}
+
+constexpr int findSignature(const unsigned char *data, qsizetype size)
+{
+    for (int i = 0; i < int(sizeof(kSignatures) / sizeof(kSignatures[0])); ++i) {
+        if (matches(kSignatures[i], data, size)) return i;
+    }
+    return -1;
+}
+
+constexpr bool detects(const unsigned char *data, qsizetype size, const char *format)
+{
+    const int i = findSignature(data, size);
+    if (i < 0) return format == nullptr;
+    if (format == nullptr) return false;
+    const char *a = kSignatures[i].format;
+    while (*a && *a == *format) {
+        ++a;
+        ++format;
+    }
+    return *a == *format;
+}
+
+// Таблица проверяется при компиляции
+constexpr unsigned char kJfif[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F'};
+constexpr unsigned char kBmp[] = {'B', 'M', 0x36, 0x10, 0x0E, 0x00, 0, 0, 0, 0, 0x36, 0, 0, 0};
+constexpr unsigned char kPcx[] = {0x0A, 0x05, 0x01, 0x08};
+constexpr unsigned char kText[] = {'B', 'M', 'P', ' ', 'f', 'i', 'l', 'e', 's', ' '};
+static_assert(detects(kJfif, sizeof(kJfif), "jpeg"), "JPEG signature");
+static_assert(detects(kBmp, sizeof(kBmp), "bmp"), "BMP signature");
+static_assert(detects(kPcx, sizeof(kPcx), "pcx"), "PCX signature");
+static_assert(detects(kText, sizeof(kText), nullptr), "text is not an image");
+}
+
+QByteArray sniffImageFormat(const char *data, qsizetype size)
+{
+    const int i = findSignature(reinterpret_cast<const unsigned char *>(data), qMin(size, qsizetype(kSniffBytes)));
+    return i < 0 ? QByteArray() : QByteArray(kSignatures[i].format);
+}
+
+QByteArray formatForExtension(const QString &fileName)
+{
+    const QString ext = QFileInfo(fileName).suffix().toLower();
+    if (ext == "jpg" || ext == "jpeg") return "jpeg";
+    if (ext == "tif" || ext == "tiff") return "tiff";
+    if (ext == "png" || ext == "gif" || ext == "bmp" || ext == "pcx") return ext.toLatin1();
+    return QByteArray();
+}
@@ -0,0 +1,19 @@
+#ifndef FORMATSNIFFER_H
+#define FORMATSNIFFER_H
+
+#include <QByteArray>
+#include <QString>
+
+// Определение формата по сигнатуре в первых 16 байтах файла. Байты уже
+// прочитаны для разбора заголовка, поэтому лишнего ввода-вывода нет, а
+// QImageReader получает формат явно, без перебора всех плагинов.
+constexpr int kSniffBytes = 16;
+
+// Имя формата в терминах QImageReader ("jpeg", "png", ...) или пустая строка
+QByteArray sniffImageFormat(const char *data, qsizetype size);
+inline QByteArray sniffImageFormat(const QByteArray &data) { return sniffImageFormat(data.constData(), data.size()); }
+
+// Формат, которого следует ожидать по расширению файла, или пустая строка
+QByteArray formatForExtension(const QString &fileName);
+
+#endif // FORMATSNIFFER_H
@@ -1,8 +1,12 @@
 #include "imageinfo.h"
 #include <QElapsedTimer>
 
+#include <QBuffer>
+#include <QDateTime>
+#include <QFile>
 #include <QFileInfo>
 #include <QImageReader>
+#include "formatsniffer.h"
 
 QString getCompressionInfo(const QString &format)
 {
@@ -85,22 +89,30 @@ QString getAdditionalInfo(const QString &format, const QImage &image)
 }
 
 
-ImageInfo getImageInfo(const QString &filePath)
+static ImageInfo readImageInfo(const QFileInfo &fi, qint64 fileSize, QImageReader &reader, const ExifInfo &exif,
+                               bool contentStats = false)
 {
     ImageInfo info;
-    QFileInfo fi(filePath);
-    QImageReader reader(filePath);
-    QImage image(filePath);
+    info.exif = exif;
 
+    info.filePath = fi.filePath();
     info.fileName = fi.fileName();
-    info.fileSize = QString("%1 KB").arg(fi.size() / 1024.0, 0, 'f', 1);
+    info.bytes = fileSize;
+    info.modifiedMs = fi.lastModified().toMSecsSinceEpoch();
+    info.fileSize = QString("%1 KB").arg(fileSize / 1024.0, 0, 'f', 1);
     info.format = reader.format().toUpper();
 
     QSize size = reader.size();
+    QImage image = reader.read();
+    if (!size.isValid() && !image.isNull()) size = image.size();
+    // Размер — как снимок будет показан: при повороте на 90° стороны меняются
+    if (size.isValid() && exif.swapsDimensions()) size.transpose();
     if (size.isValid()) {
+        info.width = size.width();
+        info.height = size.height();
         info.size = QString("%1 x %2").arg(size.width()).arg(size.height());
     } else {
-        info.size = image.isNull() ? "Некорректный размер" : QString("%1 x %2").arg(image.width()).arg(image.height());
+        info.size = "Некорректный размер";
     }
 
     int dpiX = static_cast<int>(image.dotsPerMeterX() * 0.0254 + 0.5);
@@ -113,6 +125,54 @@ ImageInfo getImageInfo(const QString &filePath)
     info.colorDepth = image.isNull() ? "Неизвестно" : QString("%1 бит").arg(image.depth());
     info.compression = getCompressionInfo(info.format);
     info.additionalInfo = getAdditionalInfo(info.format, image);
+    if (contentStats) computeContentStats(image, &info.content);
+
+    return info;
+}
+
+ImageInfo getImageInfo(const QString &filePath)
+{
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly)) return getImageInfo(filePath, file.readAll());
 
+    // Файл не открылся — строка с ошибкой от QImageReader
+    QFileInfo fi(filePath);
+    QImageReader reader(filePath);
+    return readImageInfo(fi, fi.size(), reader, ExifInfo());
+}
+
+ImageInfo getImageInfo(const QString &filePath, const QByteArray &data, bool contentStats)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+
+    // Формат известен по сигнатуре — сразу нужный плагин, без перебора
+    const QByteArray format = sniffImageFormat(data);
+    QImageReader reader(&buffer, format);
+    if (!format.isEmpty()) reader.setAutoDetectImageFormat(false);
+    // EXIF разбирается прямо в прочитанных байтах, без отдельного чтения
+    ExifInfo exif;
+    parseExif(data.constData(), data.size(), &exif);
+    ImageInfo info = readImageInfo(QFileInfo(filePath), data.size(), reader, exif, contentStats);
+
+    const QByteArray expected = formatForExtension(filePath);
+    if (!format.isEmpty() && expected != format)
+        info.additionalInfo += expected.isEmpty() ? QString(", нет расширения изображения")
+                                                  : QString(", расширение не соответствует содержимому");
     return info;
 }
+
+qint64 estimateDecodedBytes(const QByteArray &data)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    const QByteArray format = sniffImageFormat(data);
+    QImageReader reader(&buffer, format);
+    if (!format.isEmpty()) reader.setAutoDetectImageFormat(false);
+    QSize size = reader.size();
+    // Размер в заголовке не найден — грубо считаем, что изображение вчетверо больше файла
+    if (!size.isValid()) return qint64(data.size()) * 4;
+    return qint64(size.width()) * size.height() * 4;
+}
@@ -3,8 +3,13 @@
 
 #include <QString>
 #include <QImage>
+#include <QByteArray>
+#include <QMetaType>
+#include "contentstats.h"
+#include "exif.h"
 
 struct ImageInfo {
+    QString filePath;
     QString fileName;
     QString size;
     QString resolution;
@@ -13,9 +18,20 @@ struct ImageInfo {
     QString format;
     QString fileSize;
     QString additionalInfo;
+    qint64 bytes = 0;
+    qint64 modifiedMs = 0;
+    int width = 0;
+    int height = 0;
+    ExifInfo exif;
+    ContentStats content;     // заполняется, только если включена статистика содержимого
 };
 
+Q_DECLARE_METATYPE(ImageInfo)
+
 ImageInfo getImageInfo(const QString &filePath);
+// contentStats — заодно посчитать ContentStats по уже декодированному изображению
+ImageInfo getImageInfo(const QString &filePath, const QByteArray &data, bool contentStats = false);
+qint64 estimateDecodedBytes(const QByteArray &data);
 
 #endif // IMAGEINFO_H
 
@@ -0,0 +1,55 @@
+#include "indexclient.h"
+#include <QJsonDocument>
+#include <QElapsedTimer>
+
+QString IndexClient::defaultSocketName()
+{
+    return "lab2-image-indexer";
+}
+
+IndexClient::IndexClient(const QString &socketName)
+    : m_socketName(socketName) {}
+
+bool IndexClient::connectToServer(int timeoutMs)
+{
+    m_socket.connectToServer(m_socketName);
+    if (!m_socket.waitForConnected(timeoutMs)) {
+        m_error = m_socket.errorString();
+        return false;
+    }
+    return true;
+}
+
+QJsonObject IndexClient::request(const QJsonObject &req, int timeoutMs)
+{
+    if (m_socket.state() != QLocalSocket::ConnectedState && !connectToServer()) return QJsonObject();
+
+    m_socket.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + '\n');
+    m_socket.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_socket.canReadLine()) {
+        int left = timeoutMs - int(timer.elapsed());
+        if (left <= 0 || !m_socket.waitForReadyRead(left)) {
+            m_error = "Индексатор не ответил";
+            return QJsonObject();
+        }
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(m_socket.readLine(), &parseError);
+    if (!doc.isObject()) {
+        m_error = parseError.errorString();
+        return QJsonObject();
+    }
+
+    QJsonObject reply = doc.object();
+    if (!reply.value("ok").toBool()) m_error = reply.value("error").toString();
+    return reply;
+}
+
+QString IndexClient::errorString() const
+{
+    return m_error;
+}
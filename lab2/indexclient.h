@@ -0,0 +1,25 @@
+#ifndef INDEXCLIENT_H
+#define INDEXCLIENT_H
+
+#include <QLocalSocket>
+#include <QJsonObject>
+
+// Клиент фонового индексатора (imageindexer). Запрос и ответ — одна строка JSON
+// через локальный сокет (на Unix — Unix-domain socket).
+class IndexClient {
+public:
+    static QString defaultSocketName();
+
+    explicit IndexClient(const QString &socketName = defaultSocketName());
+
+    bool connectToServer(int timeoutMs = 200);
+    QJsonObject request(const QJsonObject &req, int timeoutMs = 30000);
+    QString errorString() const;
+
+private:
+    QString m_socketName;
+    QLocalSocket m_socket;
+    QString m_error;
+};
+
+#endif // INDEXCLIENT_H
@@ -0,0 +1,44 @@
+QT       += core gui network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = imageindexer
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../catalog.cpp \
+    ../checkpoint.cpp \
+    ../concurrencycontroller.cpp \
+    ../contentstats.cpp \
+    ../directorywalker.cpp \
+    ../exif.cpp \
+    ../fileidentity.cpp \
+    ../formatsniffer.cpp \
+    ../imageinfo.cpp \
+    ../indexclient.cpp \
+    ../memorybudget.cpp \
+    ../scanengine.cpp \
+    indexserver.cpp \
+    main.cpp
+
+HEADERS += \
+    ../catalog.h \
+    ../checkpoint.h \
+    ../concurrencycontroller.h \
+    ../contentstats.h \
+    ../directorywalker.h \
+    ../exif.h \
+    ../fileidentity.h \
+    ../formatsniffer.h \
+    ../imageinfo.h \
+    ../indexclient.h \
+    ../memorybudget.h \
+    ../scanengine.h \
+    indexserver.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
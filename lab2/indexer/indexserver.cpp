@@ -0,0 +1,329 @@
+#include "indexserver.h"
+#include "indexclient.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QThreadPool>
+#include <climits>
+
+namespace {
+const int kDirtyDelayMs = 500;                       // изменения в папке обычно приходят пачкой
+const int kRescanIntervalMs = 30 * 60 * 1000;        // страховочный полный обход
+
+QJsonObject errorReply(const QString &message)
+{
+    QJsonObject reply;
+    reply["ok"] = false;
+    reply["error"] = message;
+    return reply;
+}
+}
+
+IndexServer::IndexServer(const QStringList &roots, QObject *parent)
+    : QObject(parent),
+      m_server(new QLocalServer(this)),
+      m_engine(new ScanEngine(this)),
+      m_watcher(new QFileSystemWatcher(this)),
+      m_dirtyTimer(new QTimer(this)),
+      m_rescanTimer(new QTimer(this))
+{
+    ScanOptions options = m_engine->options();
+    options.maxFiles = INT_MAX;
+    // Каталог и так пересобирается при перезапуске; старый журнал дал бы устаревшие строки
+    options.checkpoints = false;
+    // Слежение за папками работает по расширениям — обход должен видеть те же файлы
+    options.detectByContent = false;
+    m_engine->setOptions(options);
+
+    m_dirtyTimer->setSingleShot(true);
+    m_dirtyTimer->setInterval(kDirtyDelayMs);
+    m_rescanTimer->setInterval(kRescanIntervalMs);
+
+    connect(m_server, &QLocalServer::newConnection, this, &IndexServer::onNewConnection);
+    connect(m_engine, &ScanEngine::resultsReady, this, &IndexServer::onResultsReady);
+    connect(m_engine, &ScanEngine::finished, this, &IndexServer::onScanFinished);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &IndexServer::onDirectoryChanged);
+    connect(m_dirtyTimer, &QTimer::timeout, this, &IndexServer::refreshDirtyDirectories);
+    connect(m_rescanTimer, &QTimer::timeout, this, &IndexServer::rescanAll);
+
+    for (const QString &root : roots) addRoot(root);
+}
+
+IndexServer::~IndexServer()
+{
+    m_engine->cancel();
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+bool IndexServer::listen(const QString &socketName, QString *error)
+{
+    IndexClient probe(socketName);
+    if (probe.connectToServer(100)) {
+        *error = "Индексатор уже запущен";
+        return false;
+    }
+
+    // Сокет мог остаться от аварийно завершённого процесса
+    QLocalServer::removeServer(socketName);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(socketName)) {
+        *error = m_server->errorString();
+        return false;
+    }
+
+    m_rescanTimer->start();
+    scanNextRoot();
+    return true;
+}
+
+void IndexServer::addRoot(const QString &root)
+{
+    QString path = QDir::cleanPath(QDir(root).absolutePath());
+    if (m_roots.contains(path) || !QDir(path).exists()) return;
+    m_roots.append(path);
+    m_pendingRoots.append(path);
+}
+
+QString IndexServer::rootFor(const QString &folder) const
+{
+    QString path = QDir::cleanPath(folder);
+    for (const QString &root : m_roots) {
+        if (path == root || path.startsWith(root + '/')) return root;
+    }
+    return QString();
+}
+
+void IndexServer::scanNextRoot()
+{
+    if (m_engine->isRunning() || m_pendingRoots.isEmpty()) return;
+
+    m_scanningRoot = m_pendingRoots.takeFirst();
+    m_seen.clear();
+    watchTree(m_scanningRoot);
+    m_engine->start(m_scanningRoot);
+}
+
+void IndexServer::rescanAll()
+{
+    for (const QString &root : m_roots) {
+        if (!m_pendingRoots.contains(root) && root != m_scanningRoot) m_pendingRoots.append(root);
+    }
+    scanNextRoot();
+}
+
+void IndexServer::onResultsReady(const QVector<ImageInfo> &batch)
+{
+    for (const ImageInfo &info : batch) {
+        m_catalog.insert(info);
+        m_seen.insert(info.filePath);
+    }
+}
+
+void IndexServer::onScanFinished(int processed, qint64 elapsedMs)
+{
+    Q_UNUSED(processed);
+    Q_UNUSED(elapsedMs);
+
+    m_catalog.retainUnder(m_scanningRoot, m_seen);
+    m_indexedRoots.insert(m_scanningRoot);
+    m_scanningRoot.clear();
+    m_seen.clear();
+    scanNextRoot();
+}
+
+void IndexServer::watchTree(const QString &root)
+{
+    QStringList dirs;
+    if (!m_watched.contains(root)) dirs.append(root);
+    QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString dir = it.next();
+        if (!m_watched.contains(dir)) dirs.append(dir);
+    }
+    if (dirs.isEmpty()) return;
+
+    m_watcher->addPaths(dirs);
+    for (const QString &dir : dirs) m_watched.insert(dir);
+}
+
+void IndexServer::onDirectoryChanged(const QString &dir)
+{
+    m_dirtyDirs.insert(dir);
+    m_dirtyTimer->start();
+}
+
+void IndexServer::refreshDirtyDirectories()
+{
+    const QSet<QString> dirs = m_dirtyDirs;
+    m_dirtyDirs.clear();
+    for (const QString &dir : dirs) refreshDirectory(dir);
+}
+
+void IndexServer::refreshDirectory(const QString &dir)
+{
+    QDir d(dir);
+    if (!d.exists()) {
+        m_watched.remove(dir);
+        m_catalog.retainUnder(dir, QSet<QString>());
+        return;
+    }
+
+    QSet<QString> present;
+    QStringList changed;
+    const QFileInfoList files = d.entryInfoList(ScanEngine::nameFilters(), QDir::Files);
+    for (const QFileInfo &fi : files) {
+        const QString path = fi.filePath();
+        present.insert(path);
+        if (!m_catalog.contains(path)) {
+            changed.append(path);
+            continue;
+        }
+        ImageInfo old = m_catalog.value(path);
+        if (old.bytes != fi.size() || old.modifiedMs != fi.lastModified().toMSecsSinceEpoch())
+            changed.append(path);
+    }
+
+    for (const ImageInfo &info : m_catalog.entriesIn(dir)) {
+        if (!present.contains(info.filePath)) m_catalog.remove(info.filePath);
+    }
+
+    // Новые вложенные папки: начинаем следить и индексируем их содержимое
+    const QFileInfoList subdirs = d.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo &sub : subdirs) {
+        if (m_watched.contains(sub.filePath())) continue;
+        watchTree(sub.filePath());
+        QDirIterator it(sub.filePath(), ScanEngine::nameFilters(), QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) changed.append(it.next());
+    }
+
+    if (changed.isEmpty()) return;
+
+    QThreadPool::globalInstance()->start([this, changed] {
+        QVector<ImageInfo> infos;
+        infos.reserve(changed.size());
+        for (const QString &path : changed) infos.append(getImageInfo(path));
+        QMetaObject::invokeMethod(this, [this, infos] { applyUpdates(infos); }, Qt::QueuedConnection);
+    });
+}
+
+void IndexServer::applyUpdates(const QVector<ImageInfo> &infos)
+{
+    for (const ImageInfo &info : infos) {
+        if (!QFileInfo::exists(info.filePath)) continue;
+        m_catalog.insert(info);
+        // Иначе идущий сейчас полный обход посчитает файл удалённым
+        if (!m_scanningRoot.isEmpty()) m_seen.insert(info.filePath);
+    }
+}
+
+void IndexServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, &IndexServer::onClientReadyRead);
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void IndexServer::onClientReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) return;
+
+    while (socket->canReadLine()) {
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(socket->readLine(), &parseError);
+        QJsonObject reply = doc.isObject() ? handle(doc.object()) : errorReply(parseError.errorString());
+        socket->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n');
+    }
+}
+
+QVector<ImageInfo> IndexServer::entriesFor(const QString &folder) const
+{
+    if (!folder.isEmpty()) return m_catalog.entriesUnder(folder);
+
+    QVector<ImageInfo> rows;
+    for (const QString &root : m_roots) rows += m_catalog.entriesUnder(root);
+    return rows;
+}
+
+QJsonObject IndexServer::listReply(const QString &folder, const QVector<ImageInfo> &rows) const
+{
+    QString root = folder.isEmpty() ? QString() : rootFor(folder);
+    QJsonObject reply;
+    reply["ok"] = true;
+    reply["indexed"] = folder.isEmpty() ? m_indexedRoots.size() == m_roots.size() : m_indexedRoots.contains(root);
+    reply["rows"] = Catalog::toJson(rows);
+    return reply;
+}
+
+QJsonObject IndexServer::handle(const QJsonObject &request)
+{
+    const QString cmd = request.value("cmd").toString();
+    const QString folder = request.value("root").toString();
+    const QString field = request.value("field").toString("format");
+
+    if (!folder.isEmpty() && rootFor(folder).isEmpty() && cmd != "add-root")
+        return errorReply(QString("Папка %1 не индексируется").arg(folder));
+
+    if (cmd == "status") {
+        QJsonObject reply;
+        reply["ok"] = true;
+        reply["roots"] = QJsonArray::fromStringList(m_roots);
+        reply["indexed"] = QJsonArray::fromStringList(QStringList(m_indexedRoots.cbegin(), m_indexedRoots.cend()));
+        reply["scanning"] = m_scanningRoot;
+        reply["files"] = m_catalog.size();
+        return reply;
+    }
+
+    if (cmd == "list")
+        return listReply(folder, entriesFor(folder));
+
+    if (cmd == "filter") {
+        const QString value = request.value("value").toString();
+        if (folder.isEmpty()) {
+            QVector<ImageInfo> rows;
+            for (const QString &root : m_roots) rows += m_catalog.filter(root, field, value);
+            return listReply(folder, rows);
+        }
+        return listReply(folder, m_catalog.filter(folder, field, value));
+    }
+
+    if (cmd == "aggregate") {
+        QJsonArray groups;
+        if (folder.isEmpty()) {
+            // Сводим группы всех корней в одну таблицу
+            QMap<QString, QPair<qint64, qint64>> merged;
+            for (const QString &root : m_roots) {
+                for (const QJsonValue &g : m_catalog.aggregate(root, field)) {
+                    QPair<qint64, qint64> &m = merged[g["key"].toString()];
+                    m.first += g["count"].toInteger();
+                    m.second += g["bytes"].toInteger();
+                }
+            }
+            for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+                QJsonObject group;
+                group["key"] = it.key();
+                group["count"] = it.value().first;
+                group["bytes"] = it.value().second;
+                groups.append(group);
+            }
+        } else {
+            groups = m_catalog.aggregate(folder, field);
+        }
+        QJsonObject reply;
+        reply["ok"] = true;
+        reply["groups"] = groups;
+        return reply;
+    }
+
+    if (cmd == "add-root") {
+        addRoot(folder);
+        scanNextRoot();
+        QJsonObject reply;
+        reply["ok"] = true;
+        return reply;
+    }
+
+    return errorReply(QString("Неизвестная команда: %1").arg(cmd));
+}
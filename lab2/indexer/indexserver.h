@@ -0,0 +1,62 @@
+#ifndef INDEXSERVER_H
+#define INDEXSERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSet>
+#include "catalog.h"
+#include "scanengine.h"
+
+// Долгоживущий процесс индексатора: держит каталог метаданных для заданных
+// папок актуальным (первичный обход, слежение за изменениями, периодический
+// полный пересмотр) и отвечает на запросы list / filter / aggregate / status
+// через локальный сокет.
+class IndexServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IndexServer(const QStringList &roots, QObject *parent = nullptr);
+    ~IndexServer();
+
+    bool listen(const QString &socketName, QString *error);
+
+private slots:
+    void onNewConnection();
+    void onClientReadyRead();
+    void onResultsReady(const QVector<ImageInfo> &batch);
+    void onScanFinished(int processed, qint64 elapsedMs);
+    void onDirectoryChanged(const QString &dir);
+    void refreshDirtyDirectories();
+    void rescanAll();
+
+private:
+    QJsonObject handle(const QJsonObject &request);
+    QJsonObject listReply(const QString &folder, const QVector<ImageInfo> &rows) const;
+    QVector<ImageInfo> entriesFor(const QString &folder) const;
+    QString rootFor(const QString &folder) const;
+    void addRoot(const QString &root);
+    void scanNextRoot();
+    void watchTree(const QString &root);
+    void refreshDirectory(const QString &dir);
+    void applyUpdates(const QVector<ImageInfo> &infos);
+
+    QLocalServer *m_server;
+    ScanEngine *m_engine;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_dirtyTimer;
+    QTimer *m_rescanTimer;
+
+    Catalog m_catalog;
+    QStringList m_roots;
+    QSet<QString> m_indexedRoots;    // первичный обход завершён
+    QStringList m_pendingRoots;
+    QString m_scanningRoot;
+    QSet<QString> m_seen;            // файлы, встреченные текущим обходом
+    QSet<QString> m_watched;
+    QSet<QString> m_dirtyDirs;
+};
+
+#endif // INDEXSERVER_H
@@ -0,0 +1,95 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QJsonArray>
+#include <QTextStream>
+#include "indexserver.h"
+#include "indexclient.h"
+
+static int runClient(const QString &command, const QJsonObject &request, const QString &socketName)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    IndexClient client(socketName);
+    if (!client.connectToServer(1000)) {
+        err << "Индексатор не запущен: " << client.errorString() << Qt::endl;
+        return 1;
+    }
+
+    QJsonObject reply = client.request(request);
+    if (!reply.value("ok").toBool()) {
+        err << "Ошибка: " << client.errorString() << Qt::endl;
+        return 1;
+    }
+
+    if (command == "status") {
+        out << "Файлов в каталоге: " << reply.value("files").toInteger() << Qt::endl;
+        for (const QJsonValue &root : reply.value("roots").toArray()) {
+            bool indexed = reply.value("indexed").toArray().contains(root);
+            out << root.toString() << (indexed ? "\tпроиндексирована" : "\tобход...") << Qt::endl;
+        }
+    } else if (command == "aggregate") {
+        for (const QJsonValue &g : reply.value("groups").toArray()) {
+            out << g["key"].toString() << '\t' << g["count"].toInteger() << '\t' << g["bytes"].toInteger() << Qt::endl;
+        }
+    } else {
+        for (const QJsonValue &row : reply.value("rows").toArray()) {
+            ImageInfo info = Catalog::fromJson(row.toObject());
+            out << info.filePath << '\t' << info.size << '\t' << info.resolution << '\t' << info.colorDepth
+                << '\t' << info.compression << '\t' << info.format << '\t' << info.fileSize << Qt::endl;
+        }
+        if (!reply.value("indexed").toBool())
+            err << "Первичный обход ещё не завершён, список может быть неполным" << Qt::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("imageindexer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Фоновый индексатор метаданных изображений (лабораторная работа 2)");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "serve | status | list | filter | aggregate");
+
+    QCommandLineOption rootOption({"r", "root"}, "Папка (для serve можно указать несколько раз).", "path");
+    QCommandLineOption fieldOption({"f", "field"}, "Поле: name, size, resolution, depth, compression, format, info, camera.", "field", "format");
+    QCommandLineOption valueOption("value", "Искомое значение для filter.", "value");
+    QCommandLineOption socketOption("socket", "Имя локального сокета.", "name", IndexClient::defaultSocketName());
+    parser.addOption(rootOption);
+    parser.addOption(fieldOption);
+    parser.addOption(valueOption);
+    parser.addOption(socketOption);
+    parser.process(app);
+
+    const QString command = parser.positionalArguments().value(0, "serve");
+    const QString socketName = parser.value(socketOption);
+
+    if (command == "serve") {
+        if (parser.values(rootOption).isEmpty()) {
+            QTextStream(stderr) << "Не заданы папки для индексации (--root)" << Qt::endl;
+            return 1;
+        }
+        IndexServer server(parser.values(rootOption));
+        QString error;
+        if (!server.listen(socketName, &error)) {
+            QTextStream(stderr) << error << Qt::endl;
+            return 1;
+        }
+        return app.exec();
+    }
+
+    if (command != "status" && command != "list" && command != "filter" && command != "aggregate")
+        parser.showHelp(1);
+
+    QJsonObject request;
+    request["cmd"] = command;
+    const QString root = parser.value(rootOption);
+    request["root"] = root.isEmpty() ? QString() : QDir::cleanPath(QDir(root).absolutePath());
+    request["field"] = parser.value(fieldOption);
+    request["value"] = parser.value(valueOption);
+    return runClient(command, request, socketName);
+}
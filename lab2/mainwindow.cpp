@@ -1,25 +1,43 @@
 
 #include "mainwindow.h"
 #include "imageinfo.h"
+#include "catalog.h"
+#include "indexclient.h"
+#include "snapshot.h"
 #include <QFileDialog>
-#include <QDirIterator>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QElapsedTimer>
-#include <QApplication>
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QFont>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QThreadPool>
+
+namespace {
+const int kIndexerTimeoutMs = 5000;     // дольше — сканируем сами
+}
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent)
+    : QMainWindow(parent),
+      scanEngine(new ScanEngine(this)),
+      scanEstimator(new ScanEstimator(this)),
+      resultExporter(new ResultExporter(this)),
+      linkDuplicates(0),
+      linkLoops(0),
+      restoredFiles(0)
 {
     setupUI();
     showMaximized();
     setWindowTitle("📁 Image Info Scanner");
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow()
+{
+    // Запрос к индексатору обращается к окну по завершении
+    QThreadPool::globalInstance()->waitForDone();
+}
 
 void MainWindow::setupUI()
 {
@@ -33,8 +51,7 @@ void MainWindow::setupUI()
     folderPathEdit = new QLineEdit(this);
     folderPathEdit->setReadOnly(true);
 
-    btnLoadImages = new QPushButton("Загрузить папку", this);
-    btnLoadImages->setStyleSheet(R"(
+    const QString buttonStyle = R"(
         QPushButton {
             background-color: #3498db;
             color: white;
@@ -45,29 +62,71 @@ void MainWindow::setupUI()
         QPushButton:hover {
             background-color: #2980b9;
         }
-    )");
+        QPushButton:disabled {
+            background-color: #95a5a6;
+        }
+    )";
+
+    btnLoadImages = new QPushButton("Загрузить папку", this);
+    btnLoadImages->setStyleSheet(buttonStyle);
+
+    btnSaveSnapshot = new QPushButton("Сохранить снимок", this);
+    btnSaveSnapshot->setStyleSheet(buttonStyle);
+    btnSaveSnapshot->setEnabled(false);
+
+    btnExport = new QPushButton("Экспорт", this);
+    btnExport->setStyleSheet(buttonStyle);
+    btnExport->setToolTip("Выгрузка результатов в CSV или колоночный формат *.l2col");
+    btnExport->setEnabled(false);
+
+    btnCompareSnapshots = new QPushButton("Сравнить снимки", this);
+    btnCompareSnapshots->setStyleSheet(buttonStyle);
+
+    btnEstimate = new QPushButton("Оценка папки", this);
+    btnEstimate->setStyleSheet(buttonStyle);
+    btnEstimate->setToolTip("Быстрая оценка по случайной выборке файлов без полного сканирования");
+
+    // Лимит памяти под одновременно декодируемые изображения
+    memoryBudgetSpin = new QSpinBox(this);
+    memoryBudgetSpin->setRange(64, 65536);
+    memoryBudgetSpin->setSingleStep(256);
+    memoryBudgetSpin->setValue(1024);
+    memoryBudgetSpin->setSuffix(" МБ");
+    memoryBudgetSpin->setToolTip("Максимальный объём памяти под декодируемые изображения");
+
+    // Необязательная группа колонок: яркость, контраст, основные цвета, гистограмма
+    contentStatsCheck = new QCheckBox("Статистика содержимого", this);
+    contentStatsCheck->setToolTip("Яркость, контраст, основные цвета и гистограмма по копии в 1/8 размера.\n"
+                                  "Помогает найти тёмные и пустые сканы");
 
     controlLayout->addWidget(folderLabel);
     controlLayout->addWidget(folderPathEdit, 1);
+    controlLayout->addWidget(new QLabel("Память:", this));
+    controlLayout->addWidget(memoryBudgetSpin);
+    controlLayout->addWidget(contentStatsCheck);
+    controlLayout->addWidget(btnEstimate);
     controlLayout->addWidget(btnLoadImages);
+    controlLayout->addWidget(btnSaveSnapshot);
+    controlLayout->addWidget(btnExport);
+    controlLayout->addWidget(btnCompareSnapshots);
 
-    tableWidget = new QTableWidget(this);
-    tableWidget->setColumnCount(8);
-    tableWidget->setHorizontalHeaderLabels(QStringList()
-                                           << "Имя файла" << "Размер (пиксели)" << "Разрешение (DPI)"
-                                           << "Глубина цвета" << "Сжатие" << "Формат" << "Размер файла" << "Доп. информация");
+    // Таблица отображает колоночное хранилище результатов через модель
+    resultModel = new ResultTableModel(this);
+    tableView = new QTableView(this);
+    tableView->setModel(resultModel);
 
-    tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
-    tableWidget->horizontalHeader()->setStretchLastSection(true);
-    tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
-    tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    tableWidget->setAlternatingRowColors(true);
+    tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    tableView->horizontalHeader()->setStretchLastSection(true);
+    tableView->verticalHeader()->setDefaultSectionSize(28);
+    tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableView->setAlternatingRowColors(true);
 
     QFont tableFont("Segoe UI", 11);
-    tableWidget->setFont(tableFont);
+    tableView->setFont(tableFont);
 
-    tableWidget->setStyleSheet(R"(
-        QTableWidget {
+    tableView->setStyleSheet(R"(
+        QTableView {
             background-color: #ffffff;
             alternate-background-color: #f2f2f2;
             gridline-color: #d0d0d0;
@@ -83,14 +142,18 @@ void MainWindow::setupUI()
     )");
 
     // Фиксированная ширина колонок
-    tableWidget->setColumnWidth(0, 200); // Имя файла
-    tableWidget->setColumnWidth(1, 120); // Размер (пиксели)
-    tableWidget->setColumnWidth(2, 120); // DPI
-    tableWidget->setColumnWidth(3, 100); // Глубина цвета
-    tableWidget->setColumnWidth(4, 150); // Сжатие
-    tableWidget->setColumnWidth(5, 80);  // Формат
-    tableWidget->setColumnWidth(6, 100);  // Размер файла
-    tableWidget->setColumnWidth(7, 280); // Доп. информация
+    tableView->setColumnWidth(0, 200); // Имя файла
+    tableView->setColumnWidth(1, 120); // Размер (пиксели)
+    tableView->setColumnWidth(2, 120); // DPI
+    tableView->setColumnWidth(3, 100); // Глубина цвета
+    tableView->setColumnWidth(4, 150); // Сжатие
+    tableView->setColumnWidth(5, 80);  // Формат
+    tableView->setColumnWidth(6, 100);  // Размер файла
+    tableView->setColumnWidth(7, 280); // Доп. информация
+    tableView->setColumnWidth(ResultStore::Camera, 180);
+    tableView->setColumnWidth(ResultStore::Captured, 150);
+    tableView->setColumnWidth(ResultStore::Orientation, 170);
+    tableView->setColumnWidth(ResultStore::Gps, 50);
 
     progressBar = new QProgressBar(this);
     progressBar->setVisible(false);
@@ -100,7 +163,7 @@ void MainWindow::setupUI()
     statusLabel->setStyleSheet("QLabel { font-style: italic; color: #555; padding: 4px; }");
 
     mainLayout->addLayout(controlLayout);
-    mainLayout->addWidget(tableWidget, 1);
+    mainLayout->addWidget(tableView, 1);
     mainLayout->addWidget(progressBar);
     mainLayout->addWidget(statusLabel);
 
@@ -108,60 +171,417 @@ void MainWindow::setupUI()
     setStyleSheet("QMainWindow { background-color: #eaeff2; }");
 
     connect(btnLoadImages, &QPushButton::clicked, this, &MainWindow::onLoadImages);
+    connect(btnSaveSnapshot, &QPushButton::clicked, this, &MainWindow::onSaveSnapshot);
+    connect(btnCompareSnapshots, &QPushButton::clicked, this, &MainWindow::onCompareSnapshots);
+    connect(scanEngine, &ScanEngine::filesFound, this, &MainWindow::onFilesFound);
+    connect(scanEngine, &ScanEngine::resultsReady, this, &MainWindow::onResultsReady);
+    connect(scanEngine, &ScanEngine::progress, this, &MainWindow::onProgress);
+    connect(scanEngine, &ScanEngine::workersChanged, this, &MainWindow::onWorkersChanged);
+    connect(scanEngine, &ScanEngine::linksDetected, this, &MainWindow::onLinksDetected);
+    connect(scanEngine, &ScanEngine::resumed, this, &MainWindow::onScanResumed);
+    connect(scanEngine, &ScanEngine::finished, this, &MainWindow::onScanFinished);
+    connect(btnEstimate, &QPushButton::clicked, this, &MainWindow::onEstimate);
+    connect(scanEstimator, &ScanEstimator::filesSeen, this, &MainWindow::onEstimateProgress);
+    connect(scanEstimator, &ScanEstimator::finished, this, &MainWindow::onEstimateFinished);
+    connect(btnExport, &QPushButton::clicked, this, &MainWindow::onExport);
+    connect(resultExporter, &ResultExporter::progress, this, &MainWindow::onExportProgress);
+    connect(resultExporter, &ResultExporter::finished, this, &MainWindow::onExportFinished);
 }
 
 void MainWindow::onLoadImages()
 {
+    if (scanEngine->isRunning() || scanEstimator->isRunning()) return;
+
     QString folder = QFileDialog::getExistingDirectory(this, "Выберите папку", QDir::homePath());
     if (folder.isEmpty()) return;
 
     folderPathEdit->setText(folder);
 
-    QStringList formats = {"*.jpg", "*.jpeg", "*.png", "*.bmp", "*.gif", "*.tif", "*.tiff", "*.pcx"};
-    QDirIterator it(folder, formats, QDir::Files, QDirIterator::Subdirectories);
-    QStringList files;
-    while (it.hasNext() && files.size() < 100000) files.append(it.next());
-
-    if (files.isEmpty()) {
-        QMessageBox::information(this, "Информация", "В выбранной папке нет изображений!");
+    const bool contentStats = contentStatsCheck->isChecked();
+    resultModel->clear(false, contentStats);
+    btnSaveSnapshot->setEnabled(false);
+    btnExport->setEnabled(false);
+    // В каталоге индексатора статистики содержимого нет
+    if (!contentStats) {
+        queryIndexer(folder);
         return;
     }
+    startScan(folder, contentStats);
+}
+
+void MainWindow::startScan(const QString &folder, bool contentStats)
+{
+    if (contentStats) {
+        tableView->setColumnWidth(ResultStore::MeanLuma, 80);
+        tableView->setColumnWidth(ResultStore::Contrast, 80);
+        tableView->setColumnWidth(ResultStore::DominantColors, 200);
+        tableView->setColumnWidth(ResultStore::Histogram, 160);
+    }
 
-    tableWidget->setRowCount(0);
     progressBar->setVisible(true);
-    progressBar->setRange(0, files.size());
+    progressBar->setRange(0, 0);
     progressBar->setValue(0);
     btnLoadImages->setEnabled(false);
+    statusLabel->setText("Поиск файлов...");
+    linkDuplicates = 0;
+    linkLoops = 0;
+    restoredFiles = 0;
 
-    QElapsedTimer timer;
-    timer.start();
+    ScanOptions options = scanEngine->options();
+    options.memoryBudget = qint64(memoryBudgetSpin->value()) * 1024 * 1024;
+    options.contentStats = contentStats;
+    scanEngine->setOptions(options);
+    scanEngine->start(folder);
+}
 
-    int processed = 0;
-    for (const QString &filePath : files) {
-        ImageInfo info = getImageInfo(filePath);
+void MainWindow::onFilesFound(int total)
+{
+    progressBar->setRange(0, qMax(1, total));
+}
 
-        int row = tableWidget->rowCount();
-        tableWidget->insertRow(row);
+// Если запущен фоновый индексатор и папка уже проиндексирована,
+// берём готовые строки из его каталога вместо повторного сканирования.
+// Запрос идёт в фоновом потоке: зависший индексатор не блокирует окно,
+// а по истечении kIndexerTimeoutMs папка сканируется как обычно
+void MainWindow::queryIndexer(const QString &folder)
+{
+    btnLoadImages->setEnabled(false);
+    statusLabel->setText("Запрос к индексатору...");
 
-        QStringList data = {
-            info.fileName, info.size, info.resolution, info.colorDepth,
-            info.compression, info.format, info.fileSize, info.additionalInfo
-        };
+    QThreadPool::globalInstance()->start([this, folder] {
+        QElapsedTimer timer;
+        timer.start();
 
-        for (int i = 0; i < data.size(); ++i) {
-            QTableWidgetItem* item = new QTableWidgetItem(data[i]);
-            item->setTextAlignment(i == 0 || i == 7 ? Qt::AlignLeft : Qt::AlignCenter);
-            tableWidget->setItem(row, i, item);
+        IndexClient client;
+        QJsonObject reply;
+        if (client.connectToServer()) {
+            QJsonObject request;
+            request["cmd"] = "list";
+            request["root"] = folder;
+            reply = client.request(request, kIndexerTimeoutMs);
         }
+        QVector<ImageInfo> rows;
+        const bool indexed = reply.value("ok").toBool() && reply.value("indexed").toBool();
+        if (indexed) rows = Catalog::fromJson(reply.value("rows").toArray());
+        const qint64 elapsedMs = timer.elapsed();
+
+        QMetaObject::invokeMethod(this, [this, folder, indexed, rows, elapsedMs] {
+            onIndexerReply(folder, indexed, rows, elapsedMs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onIndexerReply(const QString &folder, bool indexed, const QVector<ImageInfo> &rows, qint64 elapsedMs)
+{
+    if (!indexed) {
+        startScan(folder, false);
+        return;
+    }
+
+    btnLoadImages->setEnabled(true);
+    if (rows.isEmpty()) {
+        statusLabel->setText("Готов к работе");
+        QMessageBox::information(this, "Информация", "В выбранной папке нет изображений!");
+        return;
+    }
+
+    appendRows(rows);
+    btnSaveSnapshot->setEnabled(true);
+    btnExport->setEnabled(true);
+    statusLabel->setText(QString("Загружено из индекса %1 файлов за %2 мс").arg(rows.size()).arg(elapsedMs));
+}
+
+void MainWindow::onResultsReady(const QVector<ImageInfo> &batch)
+{
+    appendRows(batch);
+}
+
+void MainWindow::appendRows(const QVector<ImageInfo> &batch)
+{
+    resultModel->append(batch);
+}
+
+void MainWindow::onProgress(int processed)
+{
+    if (progressBar->maximum() > 0) progressBar->setValue(processed);
+}
+
+void MainWindow::onWorkersChanged(int ioWorkers, int decodeWorkers, qint64 memoryInUse)
+{
+    statusLabel->setText(QString("Обработано %1 файлов. Потоки: чтение %2, декодирование %3. Память: %4 МБ")
+                             .arg(resultModel->rowCount()).arg(ioWorkers).arg(decodeWorkers)
+                             .arg(memoryInUse / (1024 * 1024)));
+}
+
+void MainWindow::onScanFinished(int processed, qint64 elapsedMs)
+{
+    progressBar->setVisible(false);
+    btnLoadImages->setEnabled(true);
+
+    if (processed == 0) {
+        statusLabel->setText("Готов к работе");
+        QMessageBox::information(this, "Информация", "В выбранной папке нет изображений!");
+        return;
+    }
+
+    btnSaveSnapshot->setEnabled(true);
+    btnExport->setEnabled(true);
+    QString status = QString("Обработано %1 файлов за %2 мс. Таблица в памяти: %3 МБ")
+                         .arg(processed).arg(elapsedMs)
+                         .arg(resultModel->store().memoryUsage() / (1024.0 * 1024.0), 0, 'f', 1);
+    if (restoredFiles > 0) status += QString(". Восстановлено из журнала: %1").arg(restoredFiles);
+    if (linkDuplicates > 0) status += QString(". Ссылок на те же файлы: %1").arg(linkDuplicates);
+    if (linkLoops > 0) status += QString(". Пропущено циклических ссылок: %1").arg(linkLoops);
+
+    const ResultStore &store = resultModel->store();
+    if (store.hasContentStats()) {
+        int dark = 0;
+        int blank = 0;
+        for (int i = 0; i < store.size(); ++i) {
+            if (!store.contentValid(i)) continue;
+            if (store.meanLuma(i) < ContentStats::kDarkLuma) ++dark;
+            if (store.contrast(i) < ContentStats::kBlankContrast) ++blank;
+        }
+        status += QString(". Тёмных: %1, однотонных: %2").arg(dark).arg(blank);
+    }
+    statusLabel->setText(status);
+}
+
+void MainWindow::onScanResumed(int restored)
+{
+    restoredFiles = restored;
+    statusLabel->setText(QString("Продолжение прерванного сканирования: восстановлено %1 файлов").arg(restored));
+}
+
+void MainWindow::onLinksDetected(int duplicates, int symlinkLoops)
+{
+    linkDuplicates = duplicates;
+    linkLoops = symlinkLoops;
+}
+
+static QString formatDuration(double ms)
+{
+    qint64 s = qint64(ms / 1000.0 + 0.5);
+    if (s < 60) return QString("%1 с").arg(s);
+    if (s < 3600) return QString("%1 мин %2 с").arg(s / 60).arg(s % 60);
+    return QString("%1 ч %2 мин").arg(s / 3600).arg((s % 3600) / 60);
+}
+
+void MainWindow::onEstimate()
+{
+    if (scanEngine->isRunning() || scanEstimator->isRunning()) return;
+
+    QString folder = QFileDialog::getExistingDirectory(this, "Выберите папку для оценки", QDir::homePath());
+    if (folder.isEmpty()) return;
+
+    folderPathEdit->setText(folder);
+    resultModel->clear();
+    btnSaveSnapshot->setEnabled(false);
+    btnExport->setEnabled(false);
+    btnLoadImages->setEnabled(false);
+    btnEstimate->setEnabled(false);
+    progressBar->setVisible(true);
+    progressBar->setRange(0, 0);
+    statusLabel->setText("Оценка: обход папки...");
+
+    // Оценка обходит и отбирает файлы так же, как сканирование с этими настройками
+    ScanOptions options = scanEngine->options();
+    options.contentStats = contentStatsCheck->isChecked();
+    scanEstimator->start(folder, options);
+}
+
+void MainWindow::onEstimateProgress(qint64 count)
+{
+    statusLabel->setText(QString("Оценка: найдено %1 файлов...").arg(count));
+}
 
-        processed++;
-        progressBar->setValue(processed);
-        if (processed % 10 == 0) QApplication::processEvents();
+void MainWindow::onEstimateFinished(const ScanEstimate &estimate)
+{
+    progressBar->setVisible(false);
+    btnLoadImages->setEnabled(true);
+    btnEstimate->setEnabled(true);
+
+    if (estimate.totalFiles == 0) {
+        statusLabel->setText("Готов к работе");
+        QMessageBox::information(this, "Информация", "В выбранной папке нет изображений!");
+        return;
+    }
+
+    // В таблице — файлы выборки
+    appendRows(estimate.sample);
+
+    QStringList formats;
+    for (const FormatShare &f : estimate.formats) {
+        formats << QString("%1: %2% (%3–%4%)").arg(f.format)
+                       .arg(f.share.value * 100, 0, 'f', 1)
+                       .arg(f.share.low * 100, 0, 'f', 1)
+                       .arg(f.share.high * 100, 0, 'f', 1);
     }
 
+    const double mp = 1e6;
+    QString summary = QString(
+        "Файлов: %1 (выборка %2, обход %3)\n\n"
+        "Форматы:\n%4\n\n"
+        "Всего пикселей: %5 Мп (%6–%7 Мп)\n"
+        "Прогноз полного сканирования (%8 потоков): %9 (%10–%11)\n\n"
+        "Интервалы — 95% доверительные.")
+        .arg(estimate.totalFiles).arg(estimate.sampled).arg(formatDuration(estimate.walkMs))
+        .arg(formats.join("\n"))
+        .arg(estimate.totalPixels.value / mp, 0, 'f', 0)
+        .arg(estimate.totalPixels.low / mp, 0, 'f', 0)
+        .arg(estimate.totalPixels.high / mp, 0, 'f', 0)
+        .arg(estimate.threads)
+        .arg(formatDuration(estimate.scanMs.value))
+        .arg(formatDuration(estimate.scanMs.low))
+        .arg(formatDuration(estimate.scanMs.high));
+
+    statusLabel->setText(QString("Оценка за %1 мс: %2 файлов, прогноз сканирования %3")
+                             .arg(estimate.elapsedMs).arg(estimate.totalFiles)
+                             .arg(formatDuration(estimate.scanMs.value)));
+    QMessageBox::information(this, "Оценка папки", summary);
+}
+
+void MainWindow::onSaveSnapshot()
+{
+    if (resultModel->store().isEmpty()) return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить снимок", QDir::homePath(), "Снимок сканирования (*.l2snap)");
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (!writeSnapshot(fileName, folderPathEdit->text(), resultModel->store(), &error)) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить снимок: " + error);
+        return;
+    }
+    statusLabel->setText(QString("Снимок сохранён: %1 файлов").arg(resultModel->rowCount()));
+}
+
+void MainWindow::onExport()
+{
+    if (resultModel->store().isEmpty() || resultExporter->isRunning()) return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт результатов", QDir::homePath(),
+                                                    "CSV (*.csv);;Колоночный формат (*.l2col)");
+    if (fileName.isEmpty()) return;
+
+    btnExport->setEnabled(false);
+    statusLabel->setText("Экспорт...");
+    resultExporter->start(resultModel->store(), fileName, ResultExporter::formatForFile(fileName));
+}
+
+void MainWindow::onExportProgress(int percent)
+{
+    statusLabel->setText(QString("Экспорт: %1%").arg(percent));
+}
+
+void MainWindow::onExportFinished(bool ok, const QString &error, qint64 bytesWritten, qint64 elapsedMs)
+{
+    btnExport->setEnabled(!resultModel->store().isEmpty());
+    if (!ok) {
+        statusLabel->setText("Экспорт не выполнен");
+        QMessageBox::warning(this, "Ошибка", "Не удалось экспортировать результаты: " + error);
+        return;
+    }
+
+    const double mb = bytesWritten / (1024.0 * 1024.0);
+    statusLabel->setText(QString("Экспортировано %1 МБ за %2 мс (%3 МБ/с)")
+                             .arg(mb, 0, 'f', 1).arg(elapsedMs)
+                             .arg(mb * 1000.0 / qMax<qint64>(1, elapsedMs), 0, 'f', 0));
+}
+
+static QString describeChange(const SnapshotChange &change)
+{
+    const SnapshotRecord &a = change.before;
+    const SnapshotRecord &b = change.after;
+    QString text = snapshotChangeName(change.kind);
+
+    if (change.kind == SnapshotChangeKind::Resized) {
+        text += QString(": %1 x %2 → %3 x %4").arg(a.width).arg(a.height).arg(b.width).arg(b.height);
+    } else if (change.kind == SnapshotChangeKind::Recompressed) {
+        QStringList details;
+        if (a.bytes != b.bytes)
+            details << QString("%1 KB → %2 KB").arg(a.bytes / 1024.0, 0, 'f', 1).arg(b.bytes / 1024.0, 0, 'f', 1);
+        if (a.format != b.format || a.compression != b.compression)
+            details << QString("%1 (%2) → %3 (%4)").arg(QString::fromUtf8(a.format), QString::fromUtf8(a.compression),
+                                                        QString::fromUtf8(b.format), QString::fromUtf8(b.compression));
+        if (a.colorDepth != b.colorDepth)
+            details << QString::fromUtf8(a.colorDepth) + " → " + QString::fromUtf8(b.colorDepth);
+        if (!details.isEmpty()) text += ": " + details.join(", ");
+    }
+    return text;
+}
+
+void MainWindow::onCompareSnapshots()
+{
+    if (scanEngine->isRunning() || scanEstimator->isRunning()) return;
+
+    QString beforeFile = QFileDialog::getOpenFileName(this, "Предыдущий снимок", QDir::homePath(), "Снимок сканирования (*.l2snap)");
+    if (beforeFile.isEmpty()) return;
+    QString afterFile = QFileDialog::getOpenFileName(this, "Новый снимок", QFileInfo(beforeFile).path(), "Снимок сканирования (*.l2snap)");
+    if (afterFile.isEmpty()) return;
+
+    btnLoadImages->setEnabled(false);
+    btnEstimate->setEnabled(false);
+    btnCompareSnapshots->setEnabled(false);
+    progressBar->setVisible(true);
+    progressBar->setRange(0, 0);
+    statusLabel->setText("Сравнение снимков...");
+
+    // Снимки в миллионы строк сравниваются в фоновом потоке, окно не замирает
+    QThreadPool::globalInstance()->start([this, beforeFile, afterFile] {
+        QElapsedTimer timer;
+        timer.start();
+
+        // В таблицу попадают только изменившиеся файлы
+        QVector<ImageInfo> rows;
+        SnapshotDiffStats stats;
+        QString error;
+        const bool ok = diffSnapshots(beforeFile, afterFile,
+                                      [&rows](const SnapshotChange &change) {
+                                          const SnapshotRecord &r = change.kind == SnapshotChangeKind::Removed ? change.before : change.after;
+                                          ImageInfo info;
+                                          info.filePath = QString::fromUtf8(r.path);
+                                          info.width = r.width;
+                                          info.height = r.height;
+                                          info.resolution = "-";
+                                          info.colorDepth = QString::fromUtf8(r.colorDepth);
+                                          info.compression = QString::fromUtf8(r.compression);
+                                          info.format = QString::fromUtf8(r.format);
+                                          info.bytes = r.bytes;
+                                          info.modifiedMs = r.modifiedMs;
+                                          info.additionalInfo = describeChange(change);
+                                          rows.append(info);
+                                      },
+                                      &stats, &error);
+        const qint64 elapsedMs = timer.elapsed();
+
+        QMetaObject::invokeMethod(this, [this, afterFile, ok, error, rows, stats, elapsedMs] {
+            onSnapshotsCompared(afterFile, ok, error, rows, stats, elapsedMs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onSnapshotsCompared(const QString &afterFile, bool ok, const QString &error,
+                                     const QVector<ImageInfo> &rows, const SnapshotDiffStats &stats, qint64 elapsedMs)
+{
     progressBar->setVisible(false);
     btnLoadImages->setEnabled(true);
+    btnEstimate->setEnabled(true);
+    btnCompareSnapshots->setEnabled(true);
+
+    resultModel->clear(true);
+    btnSaveSnapshot->setEnabled(false);
+    folderPathEdit->setText(afterFile);
+    if (ok) appendRows(rows);
+    btnExport->setEnabled(ok && !rows.isEmpty());
+
+    if (!ok) {
+        statusLabel->setText("Готов к работе");
+        QMessageBox::warning(this, "Ошибка", "Не удалось сравнить снимки: " + error);
+        return;
+    }
 
-    qint64 elapsedMs = timer.elapsed();
-    statusLabel->setText(QString("Обработано %1 файлов за %2 мс").arg(files.size()).arg(elapsedMs));
+    statusLabel->setText(QString("Было %1, стало %2 файлов. Добавлено %3, удалено %4, изменён размер %5, пересжато %6 (%7 мс)")
+                             .arg(stats.before).arg(stats.after).arg(stats.added).arg(stats.removed)
+                             .arg(stats.resized).arg(stats.recompressed).arg(elapsedMs));
 }
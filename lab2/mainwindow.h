@@ -2,12 +2,20 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTableWidget>
+#include <QTableView>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QLabel>
 #include <QProgressBar>
+#include <QSpinBox>
+#include <QCheckBox>
 #include "imageinfo.h"
+#include "scanengine.h"
+#include "estimator.h"
+#include "resulttablemodel.h"
+#include "exporter.h"
+
+struct SnapshotDiffStats;
 
 class MainWindow : public QMainWindow
 {
@@ -18,15 +26,50 @@ public:
 
 private slots:
     void onLoadImages();
+    void onFilesFound(int total);
+    void onResultsReady(const QVector<ImageInfo> &batch);
+    void onProgress(int processed);
+    void onWorkersChanged(int ioWorkers, int decodeWorkers, qint64 memoryInUse);
+    void onLinksDetected(int duplicates, int symlinkLoops);
+    void onScanResumed(int restored);
+    void onScanFinished(int processed, qint64 elapsedMs);
+    void onSaveSnapshot();
+    void onCompareSnapshots();
+    void onEstimate();
+    void onEstimateProgress(qint64 count);
+    void onEstimateFinished(const ScanEstimate &estimate);
+    void onExport();
+    void onExportProgress(int percent);
+    void onExportFinished(bool ok, const QString &error, qint64 bytesWritten, qint64 elapsedMs);
 
 private:
-    QTableWidget *tableWidget;
+    QTableView *tableView;
+    ResultTableModel *resultModel;
     QPushButton *btnLoadImages;
+    QPushButton *btnSaveSnapshot;
+    QPushButton *btnCompareSnapshots;
+    QPushButton *btnEstimate;
+    QPushButton *btnExport;
     QLineEdit *folderPathEdit;
     QProgressBar *progressBar;
     QLabel *statusLabel;
+    QSpinBox *memoryBudgetSpin;
+    QCheckBox *contentStatsCheck;
+
+    ScanEngine *scanEngine;
+    ScanEstimator *scanEstimator;
+    ResultExporter *resultExporter;
+    int linkDuplicates;
+    int linkLoops;
+    int restoredFiles;
 
     void setupUI();
+    void startScan(const QString &folder, bool contentStats);
+    void queryIndexer(const QString &folder);
+    void onIndexerReply(const QString &folder, bool indexed, const QVector<ImageInfo> &rows, qint64 elapsedMs);
+    void onSnapshotsCompared(const QString &afterFile, bool ok, const QString &error,
+                             const QVector<ImageInfo> &rows, const SnapshotDiffStats &stats, qint64 elapsedMs);
+    void appendRows(const QVector<ImageInfo> &batch);
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,47 @@
+#include "memorybudget.h"
+
+MemoryBudget::MemoryBudget(qint64 limitBytes)
+    : m_limit(limitBytes), m_inUse(0) {}
+
+void MemoryBudget::reset(qint64 limitBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limit = limitBytes;
+    m_inUse = 0;
+    m_cond.wakeAll();
+}
+
+qint64 MemoryBudget::limit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+qint64 MemoryBudget::inUse() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inUse;
+}
+
+bool MemoryBudget::acquire(qint64 bytes, const std::atomic<bool> &cancelled)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!cancelled && m_limit > 0 && m_inUse > 0 && m_inUse + bytes > m_limit)
+        m_cond.wait(&m_mutex);
+    if (cancelled) return false;
+    m_inUse += bytes;
+    return true;
+}
+
+void MemoryBudget::release(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inUse -= bytes;
+    m_cond.wakeAll();
+}
+
+void MemoryBudget::wakeAll()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cond.wakeAll();
+}
@@ -0,0 +1,31 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+// Ограничение объёма памяти, занятой данными "в полёте" (прочитанные файлы,
+// декодированные изображения). acquire() блокирует поток, пока запрос не
+// помещается в лимит; один запрос больше лимита пропускается, если больше
+// ничего не занято, чтобы огромный файл не останавливал сканирование.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(qint64 limitBytes = 0);
+
+    void reset(qint64 limitBytes);
+    qint64 limit() const;
+    qint64 inUse() const;
+
+    bool acquire(qint64 bytes, const std::atomic<bool> &cancelled);
+    void release(qint64 bytes);
+    void wakeAll();
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    qint64 m_limit;
+    qint64 m_inUse;
+};
+
+#endif // MEMORYBUDGET_H
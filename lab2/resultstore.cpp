@@ -0,0 +1,227 @@
+#include "resultstore.h"
+#include <QDateTime>
+#include <QTimeZone>
+
+quint32 StringDictionary::intern(const QString &value)
+{
+    auto it = m_codes.constFind(value);
+    if (it != m_codes.constEnd()) return it.value();
+
+    quint32 code = quint32(m_values.size());
+    m_values.append(value);
+    m_codes.insert(value, code);
+    return code;
+}
+
+qint64 StringDictionary::memoryUsage() const
+{
+    // Строка: заголовок + UTF-16 данные; хэш: узел с ключом и кодом
+    qint64 bytes = m_values.capacity() * qint64(sizeof(QString));
+    for (const QString &v : m_values) bytes += 24 + v.capacity() * 2;
+    bytes += m_codes.size() * qint64(sizeof(QString) + sizeof(quint32) + 16);
+    return bytes;
+}
+
+void StringDictionary::clear()
+{
+    m_codes.clear();
+    m_values.clear();
+}
+
+PathTrie::PathTrie()
+{
+    clear();
+}
+
+void PathTrie::clear()
+{
+    m_nodes.clear();
+    m_children.clear();
+    m_components.clear();
+    m_nodes.append(Node{kRoot, m_components.intern(QString())});
+}
+
+quint32 PathTrie::insert(const QString &path)
+{
+    quint32 node = kRoot;
+    int start = 0;
+    while (start <= path.size()) {
+        int end = path.indexOf('/', start);
+        if (end < 0) end = path.size();
+
+        quint32 name = m_components.intern(path.mid(start, end - start));
+        quint64 key = (quint64(node) << 32) | name;
+        auto it = m_children.constFind(key);
+        if (it != m_children.constEnd()) {
+            node = it.value();
+        } else {
+            quint32 child = quint32(m_nodes.size());
+            m_nodes.append(Node{node, name});
+            m_children.insert(key, child);
+            node = child;
+        }
+        start = end + 1;
+    }
+    return node;
+}
+
+QString PathTrie::path(quint32 node) const
+{
+    QStringList parts;
+    while (node != kRoot) {
+        const Node &n = m_nodes[int(node)];
+        parts.prepend(m_components.value(n.name));
+        node = n.parent;
+    }
+    return parts.join('/');
+}
+
+qint64 PathTrie::memoryUsage() const
+{
+    return m_nodes.capacity() * qint64(sizeof(Node))
+           + m_children.size() * qint64(sizeof(quint64) + sizeof(quint32) + 16)
+           + m_components.memoryUsage();
+}
+
+int ResultStore::append(const ImageInfo &info)
+{
+    m_path.append(m_paths.insert(info.filePath));
+    m_bytes.append(info.bytes);
+    m_modified.append(info.modifiedMs);
+    m_width.append(info.width);
+    m_height.append(info.height);
+    m_resolution.append(m_strings.intern(info.resolution));
+    m_depth.append(m_strings.intern(info.colorDepth));
+    m_compression.append(m_strings.intern(info.compression));
+    m_format.append(m_strings.intern(info.format));
+    m_info.append(m_strings.intern(info.additionalInfo));
+    m_camera.append(m_strings.intern(info.exif.camera));
+    m_captured.append(info.exif.capturedMs);
+    m_orientation.append(quint8(info.exif.orientation));
+    m_gps.append(info.exif.hasGps ? 1 : 0);
+    if (m_hasContent) {
+        const ContentStats &c = info.content;
+        m_luma.append(c.valid ? c.meanLuma : -1.0f);
+        m_contrast.append(c.contrast);
+        for (int k = 0; k < ContentStats::kDominant; ++k)
+            m_dominant.append(k < c.dominantCount ? c.dominant[k] : QRgb(0));
+        for (int k = 0; k < ContentStats::kBins; ++k) m_histogram.append(c.histogram[k]);
+    }
+    return m_path.size() - 1;
+}
+
+void ResultStore::clear()
+{
+    m_paths.clear();
+    m_strings.clear();
+    m_path.clear();
+    m_bytes.clear();
+    m_modified.clear();
+    m_width.clear();
+    m_height.clear();
+    m_resolution.clear();
+    m_depth.clear();
+    m_compression.clear();
+    m_format.clear();
+    m_info.clear();
+    m_camera.clear();
+    m_captured.clear();
+    m_orientation.clear();
+    m_gps.clear();
+    m_luma.clear();
+    m_contrast.clear();
+    m_dominant.clear();
+    m_histogram.clear();
+}
+
+QString ResultStore::text(int i, int column) const
+{
+    switch (column) {
+    case Name:
+        return m_showFullPath ? m_paths.path(m_path[i]) : m_paths.name(m_path[i]);
+    case Size:
+        if (m_width[i] <= 0 || m_height[i] <= 0) return "Некорректный размер";
+        return QString("%1 x %2").arg(m_width[i]).arg(m_height[i]);
+    case Resolution:
+        return m_strings.value(m_resolution[i]);
+    case Depth:
+        return m_strings.value(m_depth[i]);
+    case Compression:
+        return m_strings.value(m_compression[i]);
+    case Format:
+        return m_strings.value(m_format[i]);
+    case FileSize:
+        return QString("%1 KB").arg(m_bytes[i] / 1024.0, 0, 'f', 1);
+    case Info:
+        return m_strings.value(m_info[i]);
+    case Camera:
+        return m_strings.value(m_camera[i]);
+    case Captured:
+        if (m_captured[i] == 0) return QString();
+        return QDateTime::fromMSecsSinceEpoch(m_captured[i], QTimeZone::UTC).toString("yyyy-MM-dd HH:mm:ss");
+    case Orientation:
+        return orientationText(m_orientation[i]);
+    case Gps:
+        return m_gps[i] ? "Есть" : QString();
+    }
+
+    if (!m_hasContent || column >= ColumnCount) return QString();
+    if (!contentValid(i)) return "—";
+    switch (column) {
+    case MeanLuma:
+        return QString::number(m_luma[i], 'f', 1);
+    case Contrast:
+        return QString::number(m_contrast[i], 'f', 1);
+    case DominantColors: {
+        const QRgb *colors = m_dominant.constData() + qsizetype(i) * ContentStats::kDominant;
+        int count = 0;
+        while (count < ContentStats::kDominant && colors[count] != 0) ++count;
+        return dominantColorsText(colors, count);
+    }
+    case Histogram:
+        return histogramText(m_histogram.constData() + qsizetype(i) * ContentStats::kBins);
+    }
+    return QString();
+}
+
+ImageInfo ResultStore::row(int i) const
+{
+    ImageInfo info;
+    info.filePath = filePath(i);
+    info.fileName = m_paths.name(m_path[i]);
+    info.size = text(i, Size);
+    info.resolution = text(i, Resolution);
+    info.colorDepth = text(i, Depth);
+    info.compression = text(i, Compression);
+    info.format = text(i, Format);
+    info.fileSize = text(i, FileSize);
+    info.additionalInfo = text(i, Info);
+    info.bytes = m_bytes[i];
+    info.modifiedMs = m_modified[i];
+    info.width = m_width[i];
+    info.height = m_height[i];
+    info.exif.camera = m_strings.value(m_camera[i]);
+    info.exif.capturedMs = m_captured[i];
+    info.exif.orientation = m_orientation[i];
+    info.exif.hasGps = m_gps[i] != 0;
+    if (m_hasContent && contentValid(i)) {
+        ContentStats &c = info.content;
+        c.valid = true;
+        c.meanLuma = m_luma[i];
+        c.contrast = m_contrast[i];
+        for (int k = 0; k < ContentStats::kDominant; ++k) {
+            c.dominant[k] = m_dominant[i * ContentStats::kDominant + k];
+            if (c.dominant[k] != 0) c.dominantCount = k + 1;
+        }
+        for (int k = 0; k < ContentStats::kBins; ++k) c.histogram[k] = m_histogram[i * ContentStats::kBins + k];
+    }
+    return info;
+}
+
+qint64 ResultStore::memoryUsage() const
+{
+    const qint64 perRow = sizeof(quint32) * 7 + sizeof(qint64) * 3 + sizeof(qint32) * 2 + sizeof(quint8) * 2;
+    const qint64 content = m_luma.capacity() * qint64(sizeof(float) * 2)
+                           + m_dominant.capacity() * qint64(sizeof(QRgb)) + m_histogram.capacity();
+    return m_path.capacity() * perRow + content + m_paths.memoryUsage() + m_strings.memoryUsage();
+}
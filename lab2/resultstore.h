@@ -0,0 +1,157 @@
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include "imageinfo.h"
+
+// Словарь строк: каждая уникальная строка хранится один раз, строки таблицы
+// ссылаются на неё 32-битным кодом.
+class StringDictionary {
+public:
+    quint32 intern(const QString &value);
+    const QString &value(quint32 code) const { return m_values[int(code)]; }
+    int size() const { return m_values.size(); }
+    qint64 memoryUsage() const;
+    void clear();
+
+private:
+    QHash<QString, quint32> m_codes;
+    QVector<QString> m_values;
+};
+
+// Пути файлов в виде префиксного дерева компонентов: общая часть пути
+// ("/data/photos/2023/") хранится один раз для всех файлов в папке.
+class PathTrie {
+public:
+    static constexpr quint32 kRoot = 0;
+
+    PathTrie();
+
+    quint32 insert(const QString &path);
+    QString path(quint32 node) const;
+    const QString &name(quint32 node) const { return m_components.value(m_nodes[int(node)].name); }
+    quint32 parent(quint32 node) const { return m_nodes[int(node)].parent; }
+    quint32 nameCode(quint32 node) const { return m_nodes[int(node)].name; }
+    const StringDictionary &components() const { return m_components; }
+    int size() const { return m_nodes.size(); }
+    qint64 memoryUsage() const;
+    void clear();
+
+private:
+    struct Node {
+        quint32 parent;
+        quint32 name;
+    };
+
+    QVector<Node> m_nodes;
+    QHash<quint64, quint32> m_children;   // (родитель << 32 | компонент) -> узел
+    StringDictionary m_components;
+};
+
+// Колоночное хранилище результатов сканирования. Повторяющиеся строки
+// (формат, сжатие, глубина, DPI, доп. информация) кодируются словарями,
+// числовые поля хранятся как есть, отображаемый текст строится по запросу.
+class ResultStore {
+public:
+    enum Column {
+        Name,
+        Size,
+        Resolution,
+        Depth,
+        Compression,
+        Format,
+        FileSize,
+        Info,
+        Camera,
+        Captured,
+        Orientation,
+        Gps,
+        // Необязательная группа: статистика содержимого
+        MeanLuma,
+        Contrast,
+        DominantColors,
+        Histogram,
+        ColumnCount,
+        BaseColumnCount = MeanLuma
+    };
+
+    int append(const ImageInfo &info);
+    void clear();
+    // Колонки статистики содержимого хранятся, только если включены
+    void setContentStats(bool on) { m_hasContent = on; }
+    bool hasContentStats() const { return m_hasContent; }
+    int columnCount() const { return m_hasContent ? ColumnCount : BaseColumnCount; }
+    int size() const { return m_path.size(); }
+    bool isEmpty() const { return m_path.isEmpty(); }
+
+    ImageInfo row(int i) const;
+    QString text(int i, int column) const;
+    QString filePath(int i) const { return m_paths.path(m_path[i]); }
+    qint64 bytes(int i) const { return m_bytes[i]; }
+    qint64 modifiedMs(int i) const { return m_modified[i]; }
+    int width(int i) const { return m_width[i]; }
+    int height(int i) const { return m_height[i]; }
+    const QString &format(int i) const { return m_strings.value(m_format[i]); }
+    const QString &compression(int i) const { return m_strings.value(m_compression[i]); }
+    const QString &colorDepth(int i) const { return m_strings.value(m_depth[i]); }
+    float meanLuma(int i) const { return m_luma[i]; }
+    float contrast(int i) const { return m_contrast[i]; }
+    bool contentValid(int i) const { return m_luma[i] >= 0; }
+
+    // Колонки целиком — для записи в файл без построения строк (ResultExporter)
+    const PathTrie &paths() const { return m_paths; }
+    const StringDictionary &strings() const { return m_strings; }
+    const QVector<quint32> &pathColumn() const { return m_path; }
+    const QVector<qint64> &bytesColumn() const { return m_bytes; }
+    const QVector<qint64> &modifiedColumn() const { return m_modified; }
+    const QVector<qint32> &widthColumn() const { return m_width; }
+    const QVector<qint32> &heightColumn() const { return m_height; }
+    const QVector<quint32> &resolutionColumn() const { return m_resolution; }
+    const QVector<quint32> &depthColumn() const { return m_depth; }
+    const QVector<quint32> &compressionColumn() const { return m_compression; }
+    const QVector<quint32> &formatColumn() const { return m_format; }
+    const QVector<quint32> &infoColumn() const { return m_info; }
+    const QVector<quint32> &cameraColumn() const { return m_camera; }
+    const QVector<qint64> &capturedColumn() const { return m_captured; }
+    const QVector<quint8> &orientationColumn() const { return m_orientation; }
+    const QVector<quint8> &gpsColumn() const { return m_gps; }
+    const QVector<float> &lumaColumn() const { return m_luma; }
+    const QVector<float> &contrastColumn() const { return m_contrast; }
+    const QVector<QRgb> &dominantColumn() const { return m_dominant; }
+    const QVector<quint8> &histogramColumn() const { return m_histogram; }
+
+    // В режиме сравнения снимков в колонке имени показывается путь целиком
+    void setShowFullPath(bool on) { m_showFullPath = on; }
+
+    qint64 memoryUsage() const;
+
+private:
+    bool m_showFullPath = false;
+    bool m_hasContent = false;
+    PathTrie m_paths;
+    StringDictionary m_strings;
+
+    QVector<quint32> m_path;
+    QVector<qint64> m_bytes;
+    QVector<qint64> m_modified;
+    QVector<qint32> m_width;
+    QVector<qint32> m_height;
+    QVector<quint32> m_resolution;
+    QVector<quint32> m_depth;
+    QVector<quint32> m_compression;
+    QVector<quint32> m_format;
+    QVector<quint32> m_info;
+    QVector<quint32> m_camera;
+    QVector<qint64> m_captured;                   // 0 — даты съёмки нет
+    QVector<quint8> m_orientation;
+    QVector<quint8> m_gps;
+
+    QVector<float> m_luma;                        // < 0 — статистику получить не удалось
+    QVector<float> m_contrast;
+    QVector<QRgb> m_dominant;                     // ContentStats::kDominant на строку, 0 — нет цвета
+    QVector<quint8> m_histogram;                  // ContentStats::kBins на строку
+};
+
+#endif // RESULTSTORE_H
@@ -0,0 +1,61 @@
+#include "resulttablemodel.h"
+
+ResultTableModel::ResultTableModel(QObject *parent)
+    : QAbstractTableModel(parent) {}
+
+int ResultTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_store.size();
+}
+
+int ResultTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_store.columnCount();
+}
+
+QVariant ResultTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+
+    if (role == Qt::DisplayRole)
+        return m_store.text(index.row(), index.column());
+    if (role == Qt::TextAlignmentRole) {
+        bool left = index.column() == ResultStore::Name || index.column() == ResultStore::Info
+                    || index.column() == ResultStore::Camera || index.column() == ResultStore::DominantColors;
+        return int(left ? Qt::AlignLeft | Qt::AlignVCenter : Qt::AlignCenter);
+    }
+    return QVariant();
+}
+
+QVariant ResultTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return section + 1;
+
+    static const QStringList headers = {
+        "Имя файла", "Размер (пиксели)", "Разрешение (DPI)", "Глубина цвета",
+        "Сжатие", "Формат", "Размер файла", "Доп. информация",
+        "Камера", "Дата съёмки", "Ориентация", "GPS",
+        "Яркость", "Контраст", "Основные цвета", "Гистограмма"
+    };
+    return headers.value(section);
+}
+
+void ResultTableModel::append(const QVector<ImageInfo> &batch)
+{
+    if (batch.isEmpty()) return;
+
+    const int first = m_store.size();
+    beginInsertRows(QModelIndex(), first, first + batch.size() - 1);
+    for (const ImageInfo &info : batch) m_store.append(info);
+    endInsertRows();
+}
+
+void ResultTableModel::clear(bool showFullPath, bool contentStats)
+{
+    beginResetModel();
+    m_store.clear();
+    m_store.setShowFullPath(showFullPath);
+    m_store.setContentStats(contentStats);
+    endResetModel();
+}
@@ -0,0 +1,29 @@
+#ifndef RESULTTABLEMODEL_H
+#define RESULTTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include "resultstore.h"
+
+// Модель таблицы поверх ResultStore: ячейки не хранятся, текст строится
+// при отрисовке только для видимых строк.
+class ResultTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit ResultTableModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void append(const QVector<ImageInfo> &batch);
+    void clear(bool showFullPath = false, bool contentStats = false);
+
+    const ResultStore &store() const { return m_store; }
+
+private:
+    ResultStore m_store;
+};
+
+#endif // RESULTTABLEMODEL_H
@@ -0,0 +1,534 @@
+#include "scanengine.h"
+#include "directorywalker.h"
+#include "formatsniffer.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+
+namespace {
+const int kTickMs = 250;         // период подстройки потоков и выдачи результатов
+const int kWaitMs = 100;
+const int kWalkBatch = 256;
+
+const QStringList kImageFilters = {"*.jpg", "*.jpeg", "*.png", "*.bmp", "*.gif", "*.tif", "*.tiff", "*.pcx"};
+
+// Относительная стоимость декодирования байта файла: сжатые форматы дают
+// больше пикселей на байт, TIFF и PCX к тому же декодируются медленнее
+int formatWeight(const QString &path)
+{
+    const QByteArray format = formatForExtension(path);
+    if (format == "jpeg") return 8;
+    if (format == "tiff") return 6;
+    if (format == "png") return 5;
+    if (format == "pcx") return 4;
+    if (format == "gif") return 3;
+    if (format == "bmp") return 1;  // почти только копирование
+    return 4;                       // без расширения изображения, найден по сигнатуре: средний вес
+}
+
+// Строка для второго пути к тому же файлу: метаданные общие, путь свой
+ImageInfo aliasInfo(const ImageInfo &primary, const QString &path)
+{
+    ImageInfo info = primary;
+    info.filePath = path;
+    info.fileName = QFileInfo(path).fileName();
+    info.additionalInfo += QString(", тот же файл, что %1").arg(primary.fileName);
+    return info;
+}
+}
+
+ScanEngine::ScanEngine(QObject *parent)
+    : QObject(parent),
+      m_supervisor(nullptr),
+      m_cancelled(false),
+      m_walkDone(false),
+      m_ioActive(0),
+      m_decodeExited(0),
+      m_processed(0),
+      m_rejected(0),
+      m_skipped(0),
+      m_accepted(0),
+      m_restored(0),
+      m_elapsedMs(0),
+      m_generation(0)
+{
+    qRegisterMetaType<QVector<ImageInfo>>("QVector<ImageInfo>");
+
+    int cores = qMax(1, QThread::idealThreadCount());
+    m_options.maxIoWorkers = qBound(2, cores * 2, 32);
+    m_options.maxDecodeWorkers = cores;
+}
+
+ScanEngine::~ScanEngine()
+{
+    cancel();
+    if (m_supervisor) {
+        m_supervisor->wait();
+        delete m_supervisor;
+    }
+}
+
+void ScanEngine::setOptions(const ScanOptions &options)
+{
+    ScanOptions o = options;
+    int cores = qMax(1, QThread::idealThreadCount());
+    if (o.maxIoWorkers <= 0) o.maxIoWorkers = qBound(2, cores * 2, 32);
+    if (o.maxDecodeWorkers <= 0) o.maxDecodeWorkers = cores;
+    m_options = o;
+}
+
+ScanOptions ScanEngine::options() const
+{
+    return m_options;
+}
+
+QStringList ScanEngine::nameFilters()
+{
+    return kImageFilters;
+}
+
+bool ScanEngine::needsIdentity(const QFileInfo &file)
+{
+    return file.isSymLink() || !formatForExtension(file.fileName()).isEmpty();
+}
+
+bool ScanEngine::isRunning() const
+{
+    return m_supervisor && m_supervisor->isRunning();
+}
+
+void ScanEngine::start(const QString &folder)
+{
+    if (isRunning()) return;
+    if (m_supervisor) {
+        m_supervisor->wait();
+        delete m_supervisor;
+    }
+
+    m_cancelled = false;
+    m_walkDone = false;
+    m_ioActive = 0;
+    m_decodeExited = 0;
+    m_paths.clear();
+    m_raw.clear();
+    m_results.clear();
+    m_linkedInfos.clear();
+    m_aliases.clear();
+    m_processed = 0;
+    m_rejected = 0;
+    m_skipped = 0;
+    m_accepted = 0;
+    m_dirPending.clear();
+    m_dirParent.clear();
+    m_completedDirs.clear();
+
+    // Диск может быть как SSD, так и HDD — начинаем с малого числа потоков чтения
+    m_io.reset(new ConcurrencyController(1, m_options.maxIoWorkers, 2));
+    m_decode.reset(new ConcurrencyController(1, m_options.maxDecodeWorkers, qMax(1, m_options.maxDecodeWorkers / 2)));
+    m_readAhead.reset(m_options.readAheadBytes);
+    m_decodeBudget.reset(m_options.memoryBudget);
+
+    m_supervisor = QThread::create([this, folder] { run(folder); });
+    // finished() — уже после выхода потока: обработчик может сразу запустить следующее
+    // сканирование, isRunning() к этому времени false. Сигнал прежнего потока,
+    // пришедший после нового start(), отбрасывается
+    const int generation = ++m_generation;
+    connect(m_supervisor, &QThread::finished, this, [this, generation] {
+        if (generation == m_generation) emit finished(m_processed, m_elapsedMs);
+    });
+    m_supervisor->start();
+}
+
+void ScanEngine::cancel()
+{
+    m_cancelled = true;
+    wakeAll();
+}
+
+void ScanEngine::wakeAll()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_ioCond.wakeAll();
+        m_decodeCond.wakeAll();
+        m_tickCond.wakeAll();
+    }
+    m_readAhead.wakeAll();
+    m_decodeBudget.wakeAll();
+}
+
+bool ScanEngine::inputExhausted() const
+{
+    return m_walkDone && m_paths.isEmpty() && m_ioActive == 0;
+}
+
+void ScanEngine::run(const QString &folder)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    restoreCheckpoint(folder);
+
+    QVector<QThread*> threads;
+    threads.append(QThread::create([this, folder] { walk(folder); }));
+    for (int i = 0; i < m_io->maxWorkers(); ++i)
+        threads.append(QThread::create([this, i] { ioWorker(i); }));
+    const int decodeWorkers = m_decode->maxWorkers();
+    for (int i = 0; i < decodeWorkers; ++i)
+        threads.append(QThread::create([this, i] { decodeWorker(i); }));
+    for (QThread *t : threads) t->start();
+
+    qint64 lastTick = timer.nsecsElapsed();
+    while (true) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_decodeExited < decodeWorkers && !m_cancelled)
+                m_tickCond.wait(&m_mutex, kTickMs);
+            if (m_decodeExited == decodeWorkers || m_cancelled) break;
+        }
+
+        qint64 now = timer.nsecsElapsed();
+        if (now - lastTick >= kTickMs * 1000000LL) {
+            int io = m_io->adjust(now - lastTick);
+            int decode = m_decode->adjust(now - lastTick);
+            lastTick = now;
+            {
+                QMutexLocker locker(&m_mutex);
+                m_ioCond.wakeAll();
+                m_decodeCond.wakeAll();
+            }
+            emit workersChanged(io, decode, m_decodeBudget.inUse());
+            flushResults();
+        }
+    }
+
+    wakeAll();
+    for (QThread *t : threads) {
+        t->wait();
+        delete t;
+    }
+
+    if (!m_cancelled) resolveLeftoverAliases();
+    flushResults();
+    // Завершённому сканированию журнал не нужен; прерванное продолжится с него
+    if (m_cancelled) m_checkpoint.close();
+    else m_checkpoint.remove();
+    m_elapsedMs = timer.elapsed();
+}
+
+void ScanEngine::restoreCheckpoint(const QString &folder)
+{
+    m_skipDirs.clear();
+    m_skipFiles.clear();
+    m_restored = 0;
+    if (!m_options.checkpoints) return;
+
+    CheckpointState state;
+    const bool resume = m_checkpoint.load(folder, m_options.contentStats, &state);
+    if (resume && !state.results.isEmpty()) {
+        m_skipDirs = state.completedDirs;
+        // Файлы из недоделанных папок пропускаются поштучно
+        for (const ImageInfo &info : std::as_const(state.results)) {
+            const QString dir = info.filePath.left(info.filePath.lastIndexOf('/'));
+            if (!m_skipDirs.contains(dir)) m_skipFiles.insert(info.filePath);
+        }
+        m_restored = state.results.size();
+        m_accepted = m_restored;
+        {
+            QMutexLocker locker(&m_resultMutex);
+            m_processed = m_restored;
+        }
+        emit resultsReady(state.results);
+        emit resumed(m_restored);
+    }
+    m_checkpoint.open(folder, m_options.contentStats, resume);
+}
+
+void ScanEngine::walk(const QString &folder)
+{
+    // При определении по содержимому обходятся все файлы: изображение
+    // может быть без расширения или с чужим
+    DirectoryWalker walker(m_options.detectByContent ? QStringList() : kImageFilters, m_options.followSymlinks);
+    walker.setIdentityFilter(needsIdentity);
+    QVector<PendingFile> batch;
+    QStringList stack;
+    int found = m_restored;
+    const bool tracking = m_options.checkpoints;
+
+    auto enqueue = [this, &batch] {
+        QMutexLocker locker(&m_mutex);
+        for (const PendingFile &file : batch) m_paths.enqueue(file);
+        m_ioCond.wakeAll();
+        batch.clear();
+    };
+
+    if (tracking) {
+        walker.setDirectoryHooks(
+            [this, &stack](const QString &dir) {
+                if (m_skipDirs.contains(dir)) return false;
+                enterDirectory(dir, stack.isEmpty() ? QString() : stack.last());
+                stack.append(dir);
+                return true;
+            },
+            [this, &stack](const QString &dir) {
+                stack.removeLast();
+                QMutexLocker locker(&m_resultMutex);
+                releaseDirectory(dir);
+                return true;
+            });
+    }
+
+    // Обход сам файлы не открывает: сигнатуру проверяет ioWorker, он же
+    // считает изображения в maxFiles. Обход останавливается, когда их набрано
+    // достаточно; уже найденные сверх того файлы пропускаются без чтения
+    walker.walk(folder, [&](const WalkEntry &entry) {
+        if (m_skipFiles.contains(entry.path)) return true;
+        if (m_accepted >= m_options.maxFiles) return false;
+        ++found;
+        if (tracking) {
+            QMutexLocker locker(&m_resultMutex);
+            ++m_dirPending[entry.directory];
+        }
+        if (entry.primary >= 0) {
+            addAlias(entry.primary, Alias{entry.path, entry.directory});
+            return true;
+        }
+        batch.append(PendingFile{entry.path, entry.directory, entry.index,
+                                 entry.size * formatWeight(entry.path), entry.linked});
+        if (batch.size() >= kWalkBatch) enqueue();
+        return true;
+    }, m_cancelled);
+
+    enqueue();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_walkDone = true;
+        m_ioCond.wakeAll();
+        m_decodeCond.wakeAll();
+    }
+
+    const WalkStats stats = walker.stats();
+    if (stats.duplicates > 0 || stats.symlinkLoops > 0)
+        emit linksDetected(int(stats.duplicates), int(stats.symlinkLoops));
+    emit filesFound(found);
+}
+
+void ScanEngine::enterDirectory(const QString &dir, const QString &parent)
+{
+    QMutexLocker locker(&m_resultMutex);
+    m_dirPending.insert(dir, 1);
+    if (parent.isEmpty()) return;
+    m_dirParent.insert(dir, parent);
+    ++m_dirPending[parent];
+}
+
+// Вызывается под m_resultMutex: файл или вложенная папка готовы
+void ScanEngine::releaseDirectory(QString dir)
+{
+    while (!dir.isEmpty()) {
+        auto it = m_dirPending.find(dir);
+        if (it == m_dirPending.end() || --it.value() > 0) return;
+        m_dirPending.erase(it);
+        m_completedDirs.append(dir);
+        dir = m_dirParent.take(dir);
+    }
+}
+
+void ScanEngine::addAlias(qint64 primary, const Alias &alias)
+{
+    QMutexLocker locker(&m_resultMutex);
+    auto it = m_linkedInfos.constFind(primary);
+    if (it != m_linkedInfos.constEnd()) {
+        m_results.append(aliasInfo(it.value(), alias.path));
+        ++m_processed;
+        if (m_options.checkpoints) releaseDirectory(alias.dir);
+    } else {
+        m_aliases[primary].append(alias);
+    }
+}
+
+void ScanEngine::appendResult(const PendingFile &file, const ImageInfo &info)
+{
+    QMutexLocker locker(&m_resultMutex);
+    m_results.append(info);
+    ++m_processed;
+    if (m_options.checkpoints) releaseDirectory(file.dir);
+
+    const QVector<Alias> aliases = m_aliases.take(file.index);
+    for (const Alias &alias : aliases) {
+        m_results.append(aliasInfo(info, alias.path));
+        ++m_processed;
+        if (m_options.checkpoints) releaseDirectory(alias.dir);
+    }
+    // Ссылки на файл с одной жёсткой ссылкой (символические) редки —
+    // их строки кэшируются только для файлов, у которых ссылок несколько
+    if (file.linked) m_linkedInfos.insert(file.index, info);
+}
+
+// Символическая ссылка, найденная уже после декодирования своей цели:
+// такой файл читается ещё раз, чтобы не держать в памяти все строки
+void ScanEngine::resolveLeftoverAliases()
+{
+    QHash<qint64, QVector<Alias>> aliases;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        aliases.swap(m_aliases);
+    }
+    for (const QVector<Alias> &group : std::as_const(aliases)) {
+        if (group.isEmpty()) continue;
+        const QString first = group.first().path;
+        QFile file(first);
+        const QByteArray data = file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+        const bool image = !m_options.detectByContent || !sniffImageFormat(data).isEmpty()
+                           || !formatForExtension(first).isEmpty();
+        ImageInfo info;
+        if (image) info = getImageInfo(first, data, m_options.contentStats);
+
+        QMutexLocker locker(&m_resultMutex);
+        for (const Alias &alias : group) {
+            if (!image) {
+                ++m_rejected;
+                if (m_options.checkpoints) releaseDirectory(alias.dir);
+                continue;
+            }
+            m_results.append(alias.path == first ? info : aliasInfo(info, alias.path));
+            ++m_processed;
+            if (m_options.checkpoints) releaseDirectory(alias.dir);
+        }
+    }
+}
+
+void ScanEngine::ioWorker(int index)
+{
+    QElapsedTimer waited;
+    while (true) {
+        PendingFile pending;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (true) {
+                if (m_cancelled || (m_walkDone && m_paths.isEmpty())) return;
+                if (index >= m_io->limit()) {
+                    m_ioCond.wait(&m_mutex, kWaitMs);
+                    continue;
+                }
+                if (!m_paths.isEmpty()) break;
+                waited.start();
+                m_ioCond.wait(&m_mutex, kWaitMs);
+                m_io->recordWait(waited.nsecsElapsed());
+            }
+            pending = m_paths.dequeue();
+            ++m_ioActive;
+        }
+
+        RawFile raw;
+        static_cast<PendingFile &>(raw) = pending;
+        bool image = !m_options.detectByContent || !formatForExtension(pending.path).isEmpty();
+        bool accepted = false;
+        const bool examined = m_accepted < m_options.maxFiles;
+        if (examined) {
+            QFile file(pending.path);
+            const bool opened = file.open(QIODevice::ReadOnly);
+            // Сигнатура — из первых байт того же чтения, отдельного обращения к файлу нет
+            char head[kSniffBytes];
+            const qint64 headSize = opened ? qMax<qint64>(0, file.read(head, kSniffBytes)) : 0;
+            image = image || !sniffImageFormat(head, headSize).isEmpty();
+            // Место в maxFiles занимает только изображение, и только после сигнатуры
+            accepted = image && m_accepted.fetch_add(1) < m_options.maxFiles;
+
+            const qint64 reserved = file.size();
+            if (opened && accepted && m_readAhead.acquire(reserved, m_cancelled)) {
+                raw.data.resize(qMax(reserved, headSize));
+                memcpy(raw.data.data(), head, size_t(headSize));
+                qint64 got = headSize;
+                while (got < raw.data.size()) {
+                    const qint64 n = file.read(raw.data.data() + got, raw.data.size() - got);
+                    if (n <= 0) break;
+                    got += n;
+                }
+                raw.data.resize(got);
+                if (got != reserved) m_readAhead.release(reserved - got);
+            }
+        }
+        m_io->recordCompletion();
+
+        if (!examined || (image && !accepted)) {
+            // Сверх maxFiles: папка остаётся незавершённой, и продолжение
+            // прерванного сканирования её пройдёт
+            QMutexLocker locker(&m_resultMutex);
+            m_skipped += 1 + m_aliases.take(pending.index).size();
+        } else if (!image) {
+            // Не изображение: файл закрыт после 16 байт и в таблицу не попадает
+            QMutexLocker locker(&m_resultMutex);
+            ++m_rejected;
+            if (m_options.checkpoints) releaseDirectory(pending.dir);
+            const QVector<Alias> aliases = m_aliases.take(pending.index);
+            for (const Alias &alias : aliases) {
+                ++m_rejected;
+                if (m_options.checkpoints) releaseDirectory(alias.dir);
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+        --m_ioActive;
+        // Нечитаемый файл тоже попадает в таблицу — строкой с ошибкой
+        if (accepted && !m_cancelled) m_raw.enqueue(raw);
+        m_decodeCond.wakeAll();
+    }
+}
+
+void ScanEngine::decodeWorker(int index)
+{
+    QElapsedTimer waited;
+    while (true) {
+        RawFile raw;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (true) {
+                if (m_cancelled) break;
+                if (m_raw.isEmpty() && inputExhausted()) break;
+                if (index >= m_decode->limit()) {
+                    m_decodeCond.wait(&m_mutex, kWaitMs);
+                    continue;
+                }
+                if (!m_raw.isEmpty()) break;
+                waited.start();
+                m_decodeCond.wait(&m_mutex, kWaitMs);
+                m_decode->recordWait(waited.nsecsElapsed());
+            }
+            if (m_cancelled || m_raw.isEmpty()) {
+                ++m_decodeExited;
+                m_tickCond.wakeAll();
+                return;
+            }
+            raw = m_raw.dequeue();
+        }
+
+        const qint64 rawBytes = raw.data.size();
+        const qint64 decodedBytes = estimateDecodedBytes(raw.data);
+        if (m_decodeBudget.acquire(decodedBytes, m_cancelled)) {
+            ImageInfo info = getImageInfo(raw.path, raw.data, m_options.contentStats);
+            m_decodeBudget.release(decodedBytes);
+            m_decode->recordCompletion();
+            appendResult(raw, info);
+        }
+        raw.data.clear();
+        m_readAhead.release(rawBytes);
+    }
+}
+
+void ScanEngine::flushResults()
+{
+    QVector<ImageInfo> batch;
+    QStringList completedDirs;
+    int processed;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        batch.swap(m_results);
+        completedDirs.swap(m_completedDirs);
+        processed = m_processed + m_rejected + m_skipped;
+    }
+    m_checkpoint.write(batch, completedDirs);
+    if (!batch.isEmpty()) emit resultsReady(batch);
+    emit progress(processed);
+}
@@ -0,0 +1,177 @@
+#ifndef SCANENGINE_H
+#define SCANENGINE_H
+
+#include <QObject>
+#include <QFileInfo>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include "imageinfo.h"
+#include "memorybudget.h"
+#include "concurrencycontroller.h"
+#include "checkpoint.h"
+
+struct ScanOptions {
+    int maxFiles = 100000;                         // читаемых изображений; копии строк по ссылкам не считаются
+    int maxIoWorkers = 0;                          // 0 — по числу ядер
+    int maxDecodeWorkers = 0;                      // 0 — по числу ядер
+    qint64 memoryBudget = 1024LL * 1024 * 1024;    // декодированные изображения
+    qint64 readAheadBytes = 256LL * 1024 * 1024;   // прочитанные, но ещё не декодированные файлы
+    bool followSymlinks = true;                    // заходить в папки по символическим ссылкам
+    bool contentStats = false;                     // яркость, контраст, цвета по копии в 1/8 размера
+    bool checkpoints = true;                       // журнал для продолжения прерванного сканирования
+    bool detectByContent = true;                   // формат по сигнатуре, а не по расширению
+};
+
+// Очередь "сначала самые дорогие" (LPT, longest processing time first):
+// крупные и медленные в декодировании файлы уходят в работу первыми, и
+// в конце сканирования остаются мелкие, которые быстро делятся между потоками.
+// T должен иметь поля cost и index; при равной стоимости — в порядке обхода.
+template <typename T>
+class CostQueue {
+public:
+    void enqueue(const T &item)
+    {
+        m_heap.push_back(item);
+        std::push_heap(m_heap.begin(), m_heap.end(), lessUrgent);
+    }
+
+    T dequeue()
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), lessUrgent);
+        T item = std::move(m_heap.back());
+        m_heap.pop_back();
+        return item;
+    }
+
+    bool isEmpty() const { return m_heap.empty(); }
+    void clear() { m_heap.clear(); }
+
+private:
+    static bool lessUrgent(const T &a, const T &b)
+    {
+        return a.cost < b.cost || (a.cost == b.cost && a.index > b.index);
+    }
+
+    std::vector<T> m_heap;
+};
+
+// Конвейер сканирования папки: обход каталогов -> чтение файлов (I/O) -> декодирование.
+// Число потоков чтения и декодирования подбирается на ходу (ConcurrencyController),
+// объём данных в полёте ограничен MemoryBudget. Очереди упорядочены по оценке
+// стоимости декодирования (размер файла x вес формата), см. CostQueue.
+// Результаты отдаются пачками через сигналы, поэтому интерфейс не блокируется. Жёсткие и символические
+// ссылки на уже найденный файл не читаются повторно: строка копируется
+// с результата первого пути. Ход сканирования пишется в журнал (ScanCheckpoint),
+// и прерванное сканирование той же папки продолжается с места остановки.
+class ScanEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScanEngine(QObject *parent = nullptr);
+    ~ScanEngine();
+
+    void setOptions(const ScanOptions &options);
+    ScanOptions options() const;
+
+    void start(const QString &folder);
+    void cancel();
+    bool isRunning() const;
+
+    static QStringList nameFilters();
+    // Файлы, для которых обход узнаёт идентичность (жёсткие и символические
+    // ссылки): с расширением изображения или сами ссылки. Остальные при
+    // определении по содержимому почти всегда не изображения, а на Windows
+    // каждый запрос идентичности — лишнее открытие файла
+    static bool needsIdentity(const QFileInfo &file);
+
+signals:
+    void filesFound(int total);
+    void resultsReady(const QVector<ImageInfo> &batch);
+    void progress(int examined);            // изображения, отброшенные по сигнатуре и пропущенные сверх maxFiles файлы
+    void workersChanged(int ioWorkers, int decodeWorkers, qint64 memoryInUse);
+    void linksDetected(int duplicates, int symlinkLoops);
+    void resumed(int restoredFiles);
+    void finished(int processed, qint64 elapsedMs);
+
+private:
+    struct PendingFile {
+        QString path;
+        QString dir;
+        qint64 index = 0;
+        qint64 cost = 0;         // оценка времени декодирования, условные единицы
+        bool linked = false;     // у файла несколько жёстких ссылок
+    };
+
+    struct Alias {
+        QString path;
+        QString dir;
+    };
+
+    struct RawFile : PendingFile {
+        QByteArray data;
+    };
+
+    void run(const QString &folder);
+    void walk(const QString &folder);
+    void ioWorker(int index);
+    void decodeWorker(int index);
+    bool inputExhausted() const;
+    void addAlias(qint64 primary, const Alias &alias);
+    void appendResult(const PendingFile &file, const ImageInfo &info);
+    void resolveLeftoverAliases();
+    void restoreCheckpoint(const QString &folder);
+    void enterDirectory(const QString &dir, const QString &parent);
+    void releaseDirectory(QString dir);
+    void flushResults();
+    void wakeAll();
+
+    ScanOptions m_options;
+    QThread *m_supervisor;
+    std::atomic<bool> m_cancelled;
+
+    std::unique_ptr<ConcurrencyController> m_io;
+    std::unique_ptr<ConcurrencyController> m_decode;
+    MemoryBudget m_readAhead;
+    MemoryBudget m_decodeBudget;
+
+    QMutex m_mutex;
+    QWaitCondition m_ioCond;
+    QWaitCondition m_decodeCond;
+    QWaitCondition m_tickCond;
+    CostQueue<PendingFile> m_paths;
+    CostQueue<RawFile> m_raw;
+    bool m_walkDone;
+    int m_ioActive;
+    int m_decodeExited;
+
+    QMutex m_resultMutex;
+    QVector<ImageInfo> m_results;
+    QHash<qint64, ImageInfo> m_linkedInfos;     // готовые строки файлов с несколькими жёсткими ссылками
+    QHash<qint64, QVector<Alias>> m_aliases;    // ссылки, ждущие результата первого пути
+    int m_processed;
+    int m_rejected;                              // файлы, оказавшиеся не изображениями
+    int m_skipped;                               // не прочитаны: maxFiles уже набран
+    std::atomic<int> m_accepted;                 // изображения в счёт maxFiles, считает ioWorker
+
+    // Папка считается обработанной, когда обойдена и все её файлы и вложенные
+    // папки готовы: счётчик = незавершённые файлы + вложенные папки + 1 на время обхода
+    QHash<QString, int> m_dirPending;
+    QHash<QString, QString> m_dirParent;
+    QStringList m_completedDirs;                 // ещё не записанные в журнал
+    ScanCheckpoint m_checkpoint;                 // только поток-супервизор
+    QSet<QString> m_skipDirs;                    // обработаны до прерывания, не меняются во время обхода
+    QSet<QString> m_skipFiles;
+    int m_restored;
+    qint64 m_elapsedMs;
+    int m_generation;                            // номер запуска, см. start()
+};
+
+#endif // SCANENGINE_H
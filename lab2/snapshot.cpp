@@ -0,0 +1,162 @@
+#include "snapshot.h"
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace {
+const quint32 kSnapshotMagic = 0x4C32534E;   // "L2SN"
+const quint32 kSnapshotVersion = 1;
+}
+
+bool writeSnapshot(const QString &fileName, const QString &root, const ResultStore &store, QString *error)
+{
+    const QDir rootDir(root);
+    QVector<SnapshotRecord> records;
+    records.reserve(store.size());
+    for (int i = 0; i < store.size(); ++i) {
+        SnapshotRecord r;
+        r.path = rootDir.relativeFilePath(store.filePath(i)).toUtf8();
+        r.bytes = store.bytes(i);
+        r.modifiedMs = store.modifiedMs(i);
+        r.width = store.width(i);
+        r.height = store.height(i);
+        r.format = store.format(i).toUtf8();
+        r.compression = store.compression(i).toUtf8();
+        r.colorDepth = store.colorDepth(i).toUtf8();
+        records.append(r);
+    }
+    std::sort(records.begin(), records.end(),
+              [](const SnapshotRecord &a, const SnapshotRecord &b) { return a.path < b.path; });
+
+    // Через временный файл: при сбое или нехватке места прежний снимок остаётся целым
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kSnapshotMagic << kSnapshotVersion << QDir::cleanPath(root)
+        << QDateTime::currentMSecsSinceEpoch() << quint64(records.size());
+    for (const SnapshotRecord &r : records) {
+        out << r.path << r.bytes << r.modifiedMs << r.width << r.height
+            << r.format << r.compression << r.colorDepth;
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+SnapshotReader::SnapshotReader()
+    : m_createdMs(0), m_count(0), m_read(0), m_error(false) {}
+
+bool SnapshotReader::open(const QString &fileName, QString *error)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = m_file.errorString();
+        return false;
+    }
+
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, version = 0;
+    m_stream >> magic >> version;
+    if (magic != kSnapshotMagic || version != kSnapshotVersion) {
+        *error = QString("%1: не файл снимка или неподдерживаемая версия").arg(fileName);
+        return false;
+    }
+    m_stream >> m_root >> m_createdMs >> m_count;
+    m_read = 0;
+    m_lastPath.clear();
+    return m_stream.status() == QDataStream::Ok;
+}
+
+bool SnapshotReader::next(SnapshotRecord &record)
+{
+    if (m_error || m_read >= m_count) return false;
+
+    m_stream >> record.path >> record.bytes >> record.modifiedMs >> record.width >> record.height
+        >> record.format >> record.compression >> record.colorDepth;
+    // Слияние корректно только для отсортированных записей
+    if (m_stream.status() != QDataStream::Ok || (m_read > 0 && record.path <= m_lastPath)) {
+        m_error = true;
+        return false;
+    }
+    m_lastPath = record.path;
+    ++m_read;
+    return true;
+}
+
+bool diffSnapshots(const QString &beforeFile, const QString &afterFile,
+                   const std::function<void(const SnapshotChange &)> &onChange,
+                   SnapshotDiffStats *stats, QString *error)
+{
+    SnapshotReader before, after;
+    if (!before.open(beforeFile, error) || !after.open(afterFile, error)) return false;
+
+    SnapshotDiffStats s;
+    s.before = qint64(before.count());
+    s.after = qint64(after.count());
+
+    SnapshotChange change;
+    SnapshotRecord a, b;
+    bool hasA = before.next(a);
+    bool hasB = after.next(b);
+
+    while (hasA || hasB) {
+        if (hasA && (!hasB || a.path < b.path)) {
+            change.kind = SnapshotChangeKind::Removed;
+            change.before = a;
+            change.after = SnapshotRecord();
+            ++s.removed;
+            onChange(change);
+            hasA = before.next(a);
+        } else if (hasB && (!hasA || b.path < a.path)) {
+            change.kind = SnapshotChangeKind::Added;
+            change.before = SnapshotRecord();
+            change.after = b;
+            ++s.added;
+            onChange(change);
+            hasB = after.next(b);
+        } else {
+            // Один и тот же файл в обоих снимках
+            bool resized = a.width != b.width || a.height != b.height;
+            bool recompressed = !resized && (a.bytes != b.bytes || a.format != b.format
+                                             || a.compression != b.compression || a.colorDepth != b.colorDepth);
+            if (resized || recompressed) {
+                change.kind = resized ? SnapshotChangeKind::Resized : SnapshotChangeKind::Recompressed;
+                change.before = a;
+                change.after = b;
+                ++(resized ? s.resized : s.recompressed);
+                onChange(change);
+            }
+            hasA = before.next(a);
+            hasB = after.next(b);
+        }
+    }
+
+    if (before.hasError() || after.hasError()) {
+        *error = "Снимок повреждён или записи не отсортированы";
+        return false;
+    }
+    if (stats) *stats = s;
+    return true;
+}
+
+QString snapshotChangeName(SnapshotChangeKind kind)
+{
+    switch (kind) {
+    case SnapshotChangeKind::Added: return "Добавлен";
+    case SnapshotChangeKind::Removed: return "Удалён";
+    case SnapshotChangeKind::Resized: return "Изменён размер";
+    case SnapshotChangeKind::Recompressed: return "Пересжат";
+    }
+    return QString();
+}
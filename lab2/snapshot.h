@@ -0,0 +1,75 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <QFile>
+#include <QDataStream>
+#include <QVector>
+#include <functional>
+#include "resultstore.h"
+
+// Снимок сканирования: записи, отсортированные по пути относительно корня.
+// Благодаря сортировке два снимка сравниваются одним линейным проходом
+// (слиянием), без загрузки в память.
+struct SnapshotRecord {
+    QByteArray path;          // относительно корня, UTF-8
+    qint64 bytes = 0;
+    qint64 modifiedMs = 0;
+    qint32 width = 0;
+    qint32 height = 0;
+    QByteArray format;
+    QByteArray compression;
+    QByteArray colorDepth;
+};
+
+enum class SnapshotChangeKind {
+    Added,
+    Removed,
+    Resized,
+    Recompressed
+};
+
+struct SnapshotChange {
+    SnapshotChangeKind kind;
+    SnapshotRecord before;
+    SnapshotRecord after;
+};
+
+struct SnapshotDiffStats {
+    qint64 before = 0;
+    qint64 after = 0;
+    qint64 added = 0;
+    qint64 removed = 0;
+    qint64 resized = 0;
+    qint64 recompressed = 0;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader();
+
+    bool open(const QString &fileName, QString *error);
+    bool next(SnapshotRecord &record);
+    bool hasError() const { return m_error; }
+
+    QString root() const { return m_root; }
+    qint64 createdMs() const { return m_createdMs; }
+    quint64 count() const { return m_count; }
+
+private:
+    QFile m_file;
+    QDataStream m_stream;
+    QString m_root;
+    qint64 m_createdMs;
+    quint64 m_count;
+    quint64 m_read;
+    QByteArray m_lastPath;
+    bool m_error;
+};
+
+bool writeSnapshot(const QString &fileName, const QString &root, const ResultStore &store, QString *error);
+bool diffSnapshots(const QString &beforeFile, const QString &afterFile,
+                   const std::function<void(const SnapshotChange &)> &onChange,
+                   SnapshotDiffStats *stats, QString *error);
+QString snapshotChangeName(SnapshotChangeKind kind);
+
+#endif // SNAPSHOT_H
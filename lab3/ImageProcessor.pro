@@ -9,13 +9,37 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    channellut.cpp \
+    convolution.cpp \
+    cpufeatures.cpp \
+    displaycache.cpp \
+    filterpipeline.cpp \
+    imagehistogram.cpp \
     imageprocessor.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    pixelaccess.cpp \
+    stripio.cpp \
+    tileexecutor.cpp \
+    valuelut.cpp
 
 HEADERS += \
+    channellut.h \
+    convolution.h \
+    cpufeatures.h \
+    displaycache.h \
+    filterpipeline.h \
+    imagehistogram.h \
     imageprocessor.h \
-    mainwindow.h
+    mainwindow.h \
+    pixelaccess.h \
+    stripio.h \
+    tileexecutor.h \
+    valuelut.h
+
+# MinGW GCC кладёт регистры AVX на невыровненный стек выровненными командами
+# (GCC PR 54412); ассемблер заменяет их невыровненными
+win32-g++: QMAKE_CXXFLAGS += -Wa,-muse-unaligned-vector-move
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -0,0 +1,44 @@
+QT       += core gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = imagebatch
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../channellut.cpp \
+    ../convolution.cpp \
+    ../cpufeatures.cpp \
+    ../filterpipeline.cpp \
+    ../imagehistogram.cpp \
+    ../imageprocessor.cpp \
+    ../pixelaccess.cpp \
+    ../stripio.cpp \
+    ../tileexecutor.cpp \
+    ../valuelut.cpp \
+    batchrunner.cpp \
+    main.cpp
+
+HEADERS += \
+    ../channellut.h \
+    ../convolution.h \
+    ../cpufeatures.h \
+    ../filterpipeline.h \
+    ../imagehistogram.h \
+    ../imageprocessor.h \
+    ../pixelaccess.h \
+    ../stripio.h \
+    ../tileexecutor.h \
+    ../valuelut.h \
+    batchrunner.h
+
+# MinGW GCC кладёт регистры AVX на невыровненный стек выровненными командами
+# (GCC PR 54412); ассемблер заменяет их невыровненными
+win32-g++: QMAKE_CXXFLAGS += -Wa,-muse-unaligned-vector-move
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
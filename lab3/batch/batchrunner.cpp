@@ -0,0 +1,193 @@
+#include "batchrunner.h"
+#include "pixelaccess.h"
+#include "tileexecutor.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QThread>
+
+namespace {
+
+const QStringList kImageFilters = { "*.png", "*.jpg", "*.jpeg", "*.bmp", "*.ppm", "*.pgm", "*.tif", "*.tiff" };
+
+// Каждое изображение в полёте занимает память целиком: очереди короткие, а
+// декодирования и записи, которые обычно не узкое место, — четверть ядер
+const int kDefaultQueueDepth = 2;
+
+int orDefault(int requested, int fallback)
+{
+    return requested > 0 ? requested : fallback;
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(const FilterPipeline &pipeline, const BatchOptions &options)
+    : m_pipeline(pipeline), m_options(options)
+{
+}
+
+QStringList BatchRunner::findImages(const QString &dir, bool recursive)
+{
+    QStringList result;
+    const QDir root(dir);
+    QDirIterator it(dir, kImageFilters, QDir::Files,
+                    recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (it.hasNext()) result.append(root.relativeFilePath(it.next()));
+    result.sort();
+    return result;
+}
+
+BatchStats BatchRunner::run(const QString &inputDir, const QStringList &files, const QString &outputDir,
+                            const std::function<void(const BatchStats &)> &progress,
+                            const std::function<void(const QString &)> &onError)
+{
+    m_inputDir = inputDir;
+    m_files = files;
+    m_outputDir = outputDir;
+    m_onError = onError;
+    m_errors.clear();
+    m_next = 0;
+    m_images = 0;
+    m_failed = 0;
+    m_pixels = 0;
+    m_decodeNs = 0;
+    m_processNs = 0;
+    m_encodeNs = 0;
+    m_elapsedMs = 0;
+
+    const int cores = qMax(1, QThread::idealThreadCount());
+    const int decoders = orDefault(m_options.decodeWorkers, qMax(1, cores / 4));
+    const int processors = orDefault(m_options.processWorkers, cores);
+    const int encoders = orDefault(m_options.encodeWorkers, qMax(1, cores / 4));
+    const int depth = orDefault(m_options.queueDepth, kDefaultQueueDepth);
+    StageQueue<Item> decoded(depth, decoders);
+    StageQueue<Item> processed(depth, processors);
+    m_decoded = &decoded;
+    m_processed = &processed;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<QThread*> threads;
+    for (int i = 0; i < decoders; ++i) threads.append(QThread::create([this] { decodeWorker(); }));
+    for (int i = 0; i < processors; ++i) threads.append(QThread::create([this] { processWorker(); }));
+    for (int i = 0; i < encoders; ++i) threads.append(QThread::create([this] { encodeWorker(); }));
+    for (QThread *t : threads) t->start();
+
+    for (QThread *t : threads) {
+        while (!t->wait(1000)) {
+            m_elapsedMs = timer.elapsed();
+            reportErrors();
+            if (progress) progress(snapshot());
+        }
+        delete t;
+    }
+    reportErrors();
+
+    m_decoded = nullptr;
+    m_processed = nullptr;
+    m_elapsedMs = timer.elapsed();
+    return snapshot();
+}
+
+void BatchRunner::decodeWorker()
+{
+    QElapsedTimer timer;
+    for (int index = m_next++; index < m_files.size(); index = m_next++) {
+        timer.start();
+        QImageReader reader(QDir(m_inputDir).filePath(m_files[index]));
+        reader.setAutoTransform(true);
+        Item item;
+        item.index = index;
+        const bool ok = reader.read(&item.image);
+        m_decodeNs += timer.nsecsElapsed();
+
+        if (!ok) {
+            fail(index, reader.errorString());
+            continue;
+        }
+        m_decoded->push(std::move(item));
+    }
+    m_decoded->producerFinished();
+}
+
+void BatchRunner::processWorker()
+{
+    TileExecutor executor(1);
+    QElapsedTimer timer;
+    Item item;
+    while (m_decoded->pop(item)) {
+        timer.start();
+        item.image = m_pipeline.run(PixelAccess::toWorkingFormat(item.image), executor);
+        m_processNs += timer.nsecsElapsed();
+        m_processed->push(std::move(item));
+    }
+    m_processed->producerFinished();
+}
+
+void BatchRunner::encodeWorker()
+{
+    QElapsedTimer timer;
+    Item item;
+    while (m_processed->pop(item)) {
+        timer.start();
+        const QString path = outputPath(item.index);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QImageWriter writer(path, m_options.format.toLatin1());
+        if (m_options.quality >= 0) writer.setQuality(m_options.quality);
+        const bool ok = writer.write(item.image);
+        m_encodeNs += timer.nsecsElapsed();
+
+        if (!ok) {
+            fail(item.index, writer.errorString());
+            continue;
+        }
+        m_pixels += qint64(item.image.width()) * item.image.height();
+        ++m_images;
+        item.image = QImage();
+    }
+}
+
+void BatchRunner::fail(int index, const QString &message)
+{
+    ++m_failed;
+    if (!m_onError) return;
+    QMutexLocker locker(&m_errorMutex);
+    m_errors.append(QString("%1: %2").arg(m_files[index], message));
+}
+
+void BatchRunner::reportErrors()
+{
+    QStringList errors;
+    {
+        QMutexLocker locker(&m_errorMutex);
+        errors.swap(m_errors);
+    }
+    for (const QString &error : std::as_const(errors)) m_onError(error);
+}
+
+QString BatchRunner::outputPath(int index) const
+{
+    QString relative = m_files[index];
+    if (!m_options.format.isEmpty()) {
+        const QFileInfo info(relative);
+        relative = QDir(info.path()).filePath(info.completeBaseName() + "." + m_options.format.toLower());
+    }
+    return QDir(m_outputDir).filePath(relative);
+}
+
+BatchStats BatchRunner::snapshot() const
+{
+    BatchStats stats;
+    stats.images = m_images;
+    stats.failed = m_failed;
+    stats.pixels = m_pixels;
+    stats.elapsedMs = m_elapsedMs;
+    stats.decodeMs = m_decodeNs / 1000000;
+    stats.processMs = m_processNs / 1000000;
+    stats.encodeMs = m_encodeNs / 1000000;
+    return stats;
+}
@@ -0,0 +1,132 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QStringList>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include "filterpipeline.h"
+
+struct BatchOptions {
+    int decodeWorkers = 0;      // 0 — четверть ядер
+    int processWorkers = 0;     // 0 — по числу ядер
+    int encodeWorkers = 0;      // 0 — четверть ядер
+    int queueDepth = 0;         // изображений между стадиями, 0 — два
+    QString format;             // формат результата, пусто — как у исходного файла
+    int quality = -1;           // QImageWriter::setQuality, -1 — по умолчанию
+};
+
+struct BatchStats {
+    int images = 0;             // записаны
+    int failed = 0;
+    qint64 pixels = 0;
+    qint64 elapsedMs = 0;
+    // Суммарное время потоков каждой стадии: где узкое место
+    qint64 decodeMs = 0;
+    qint64 processMs = 0;
+    qint64 encodeMs = 0;
+};
+
+// Очередь между стадиями конвейера. push() ждёт, пока есть место, поэтому
+// быстрая стадия не накапливает изображения в памяти; pop() ждёт элемента
+// и возвращает false, когда очередь закрыта и пуста. Закрывает её последний
+// из производителей.
+template <typename T>
+class StageQueue {
+public:
+    StageQueue(int capacity, int producers) : m_capacity(capacity), m_producers(producers) {}
+
+    void push(T item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (int(m_items.size()) >= m_capacity) m_notFull.wait(&m_mutex);
+        m_items.push_back(std::move(item));
+        m_notEmpty.wakeOne();
+    }
+
+    bool pop(T &item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_items.empty() && m_producers > 0) m_notEmpty.wait(&m_mutex);
+        if (m_items.empty()) return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    void producerFinished()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (--m_producers == 0) m_notEmpty.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    std::deque<T> m_items;
+    int m_capacity;
+    int m_producers;
+};
+
+// Пакетная обработка файлов конвейером чтение+декодирование -> фильтры ->
+// кодирование+запись, у каждой стадии свои потоки. Изображение целиком
+// обрабатывает один поток (TileExecutor на один поток): при тысячах файлов
+// параллельность между изображениями дешевле, чем деление каждого на полосы.
+class BatchRunner {
+public:
+    BatchRunner(const FilterPipeline &pipeline, const BatchOptions &options);
+
+    // Файлы изображений в папке, пути относительно неё
+    static QStringList findImages(const QString &dir, bool recursive);
+
+    // files — пути относительно inputDir; результаты ложатся в outputDir с той
+    // же структурой папок. progress и onError вызываются только из вызывающего
+    // потока: progress раз в секунду, onError по одному разу на файл — ошибки
+    // стадий копятся и отдаются перед очередным progress и в конце
+    BatchStats run(const QString &inputDir, const QStringList &files, const QString &outputDir,
+                   const std::function<void(const BatchStats &)> &progress,
+                   const std::function<void(const QString &)> &onError);
+
+private:
+    struct Item {
+        int index = -1;
+        QImage image;
+    };
+
+    void decodeWorker();
+    void processWorker();
+    void encodeWorker();
+    void fail(int index, const QString &message);
+    void reportErrors();
+    QString outputPath(int index) const;
+    BatchStats snapshot() const;
+
+    FilterPipeline m_pipeline;
+    BatchOptions m_options;
+
+    QString m_inputDir;
+    QStringList m_files;
+    QString m_outputDir;
+    std::function<void(const QString &)> m_onError;
+    StageQueue<Item> *m_decoded = nullptr;
+    StageQueue<Item> *m_processed = nullptr;
+
+    std::atomic<int> m_next;
+    std::atomic<int> m_images;
+    std::atomic<int> m_failed;
+    std::atomic<qint64> m_pixels;
+    std::atomic<qint64> m_decodeNs;
+    std::atomic<qint64> m_processNs;
+    std::atomic<qint64> m_encodeNs;
+    qint64 m_elapsedMs;
+
+    QMutex m_errorMutex;
+    QStringList m_errors;       // ещё не отданные onError
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,121 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QImageReader>
+#include <QTextStream>
+#include "batchrunner.h"
+#include "cpufeatures.h"
+
+// Цепочка из списка через запятую: contrast, equalize-rgb, equalize-hsv, sharpen
+static bool parsePipeline(const QString &spec, FilterPipeline *pipeline, QString *error)
+{
+    for (const QString &name : spec.split(',', Qt::SkipEmptyParts)) {
+        const QString op = name.trimmed().toLower();
+        if (op == "contrast") pipeline->linearContrast();
+        else if (op == "equalize-rgb") pipeline->equalizeRGB();
+        else if (op == "equalize-hsv") pipeline->equalizeHSV();
+        else if (op == "sharpen") pipeline->sharpen();
+        else {
+            *error = QString("Неизвестная операция: %1").arg(op);
+            return false;
+        }
+    }
+    if (pipeline->isEmpty()) {
+        *error = "Не задана ни одна операция (--ops)";
+        return false;
+    }
+    return true;
+}
+
+static double perSecond(double value, qint64 ms)
+{
+    return ms > 0 ? value * 1000.0 / ms : 0.0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("imagebatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Пакетная обработка папки изображений (лабораторная работа 3)");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Папка с исходными изображениями.");
+    parser.addPositionalArgument("output", "Папка для результатов.");
+
+    QCommandLineOption opsOption({"o", "ops"}, "Операции через запятую: contrast, equalize-rgb, equalize-hsv, sharpen.", "list");
+    QCommandLineOption recursiveOption({"r", "recursive"}, "Обходить вложенные папки.");
+    QCommandLineOption formatOption({"f", "format"}, "Формат результата (png, jpg, bmp, ppm); по умолчанию как у исходного.", "format");
+    QCommandLineOption qualityOption({"q", "quality"}, "Качество сжатия 0-100.", "value", "-1");
+    QCommandLineOption decodersOption("decoders", "Потоков чтения и декодирования.", "n", "0");
+    QCommandLineOption workersOption("workers", "Потоков обработки.", "n", "0");
+    QCommandLineOption encodersOption("encoders", "Потоков кодирования и записи.", "n", "0");
+    QCommandLineOption queueOption("queue", "Изображений в очереди между стадиями.", "n", "0");
+    QCommandLineOption limitOption("allocation-limit", "Предел памяти на одно декодированное изображение, МБ.", "mb", "1024");
+    parser.addOption(opsOption);
+    parser.addOption(recursiveOption);
+    parser.addOption(formatOption);
+    parser.addOption(qualityOption);
+    parser.addOption(decodersOption);
+    parser.addOption(workersOption);
+    parser.addOption(encodersOption);
+    parser.addOption(queueOption);
+    parser.addOption(limitOption);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2) parser.showHelp(1);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    FilterPipeline pipeline;
+    QString error;
+    if (!parsePipeline(parser.value(opsOption), &pipeline, &error)) {
+        err << error << Qt::endl;
+        return 1;
+    }
+
+    const QString inputDir = QDir(args[0]).absolutePath();
+    const QString outputDir = QDir(args[1]).absolutePath();
+    if (inputDir == outputDir) {
+        err << "Папка результатов должна отличаться от исходной" << Qt::endl;
+        return 1;
+    }
+    QImageReader::setAllocationLimit(parser.value(limitOption).toInt());
+
+    BatchOptions options;
+    options.decodeWorkers = parser.value(decodersOption).toInt();
+    options.processWorkers = parser.value(workersOption).toInt();
+    options.encodeWorkers = parser.value(encodersOption).toInt();
+    options.queueDepth = parser.value(queueOption).toInt();
+    options.format = parser.value(formatOption);
+    options.quality = parser.value(qualityOption).toInt();
+
+    const QStringList files = BatchRunner::findImages(inputDir, parser.isSet(recursiveOption));
+    out << "Файлов: " << files.size() << ", SIMD: " << cpuFeaturesName() << Qt::endl;
+
+    BatchRunner runner(pipeline, options);
+    const BatchStats stats = runner.run(inputDir, files, outputDir,
+        [&](const BatchStats &s) {
+            err << QString("\r%1/%2, %3 изобр/с")
+                       .arg(s.images + s.failed).arg(files.size())
+                       .arg(perSecond(s.images, s.elapsedMs), 0, 'f', 1)
+                << Qt::flush;
+        },
+        [&](const QString &message) { err << "\nОшибка: " << message << Qt::endl; });
+
+    err << '\r';
+    out << QString("Обработано %1 изображений, ошибок %2 за %3 с: %4 изобр/с, %5 Мпикс/с")
+               .arg(stats.images).arg(stats.failed)
+               .arg(stats.elapsedMs / 1000.0, 0, 'f', 1)
+               .arg(perSecond(stats.images, stats.elapsedMs), 0, 'f', 1)
+               .arg(perSecond(stats.pixels / 1e6, stats.elapsedMs), 0, 'f', 1)
+        << Qt::endl;
+    out << QString("Время потоков: декодирование %1 с, обработка %2 с, кодирование %3 с")
+               .arg(stats.decodeMs / 1000.0, 0, 'f', 1)
+               .arg(stats.processMs / 1000.0, 0, 'f', 1)
+               .arg(stats.encodeMs / 1000.0, 0, 'f', 1)
+        << Qt::endl;
+    return stats.failed == 0 ? 0 : 2;
+}
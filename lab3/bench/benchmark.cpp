@@ -0,0 +1,344 @@
+#include "benchmark.h"
+#include "channellut.h"
+#include "convolution.h"
+#include "cpufeatures.h"
+#include "filterpipeline.h"
+#include "imagehistogram.h"
+#include "imageprocessor.h"
+#include "tileexecutor.h"
+#include "valuelut.h"
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Ограничение на число повторов быстрых операций на маленьких изображениях
+constexpr int kMaxRepeats = 1000;
+
+quint32 hash(quint32 x, quint32 y)
+{
+    quint32 h = x * 0x9e3779b1u ^ y * 0x85ebca77u;
+    h ^= h >> 15;
+    h *= 0xc2b2ae3du;
+    return h ^ (h >> 13);
+}
+
+// Каналы сжаты в 32..223: на полном диапазоне таблица контрастирования
+// тождественна, и linearContrast() возвращает вход без прохода по пикселям
+QImage compressedRange(const QImage &img)
+{
+    uchar map[256];
+    for (int v = 0; v < 256; ++v) map[v] = uchar(32 + v * 191 / 255);
+
+    QImage out = img.copy();
+    if (out.format() == QImage::Format_Indexed8) {
+        QVector<QRgb> colors = out.colorTable();
+        for (QRgb &c : colors) c = qRgba(map[qRed(c)], map[qGreen(c)], map[qBlue(c)], qAlpha(c));
+        out.setColorTable(colors);
+        return out;
+    }
+    for (int y = 0; y < out.height(); ++y) {
+        uchar *line = out.scanLine(y);
+        if (out.depth() == 32) {
+            QRgb *px = reinterpret_cast<QRgb *>(line);
+            for (int x = 0; x < out.width(); ++x)
+                px[x] = qRgba(map[qRed(px[x])], map[qGreen(px[x])], map[qBlue(px[x])], qAlpha(px[x]));
+        } else {
+            for (int x = 0; x < out.width(); ++x) line[x] = map[line[x]];
+        }
+    }
+    return out;
+}
+
+// Размеры для проверки: хвосты строк короче и длиннее любого вектора, одна строка и один столбец
+const QSize kVerifySizes[] = { {1, 1}, {2, 3}, {15, 4}, {33, 17}, {64, 9}, {1, 40}, {131, 67}, {509, 5} };
+const quint32 kVerifySeed = 20240611;
+
+QJsonObject isaJson()
+{
+    QJsonObject isa;
+    isa["cpu"] = QString(cpuFeaturesName());
+    isa["convolution"] = QString(Convolution::isaName());
+    isa["channelLut"] = QString(ChannelLut::isaName());
+    isa["valueLut"] = QString(ValueLut::isaName());
+    return isa;
+}
+
+QVector<uchar> randomTable(QRandomGenerator &rng)
+{
+    QVector<uchar> table(256);
+    for (uchar &v : table) v = uchar(rng.bounded(256));
+    return table;
+}
+
+QImage randomImage(QRandomGenerator &rng, const QSize &size, QImage::Format format)
+{
+    QImage img(size, format);
+    if (format == QImage::Format_Indexed8) {
+        QVector<QRgb> colors(256);
+        for (QRgb &c : colors) c = 0xff000000u | (rng.generate() & 0xffffffu);
+        img.setColorTable(colors);
+    }
+    const int bytes = img.width() * img.depth() / 8;
+    for (int y = 0; y < img.height(); ++y) {
+        uchar *line = img.scanLine(y);
+        for (int x = 0; x < bytes; ++x) line[x] = uchar(rng.generate());
+        // В RGB32 старший байт обязан быть 0xff
+        if (format == QImage::Format_RGB32)
+            for (int x = 0; x < img.width(); ++x) reinterpret_cast<QRgb *>(line)[x] |= 0xff000000u;
+    }
+    return img;
+}
+
+// Хэш формата, размера и пикселей без выравнивания строк
+QString digest(const QImage &img)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint32 header[3] = { qint32(img.format()), img.width(), img.height() };
+    hash.addData(QByteArray::fromRawData(reinterpret_cast<const char *>(header), sizeof(header)));
+    const int bytes = img.width() * img.depth() / 8;
+    for (int y = 0; y < img.height(); ++y)
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char *>(img.constScanLine(y)), bytes));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+// Эталон для цепочки: стадии по одной, каждая — отдельной операцией с полной копией
+QImage runSequential(const FilterPipeline &pipeline, const QImage &img)
+{
+    QImage out = img;
+    for (const FilterPipeline::Stage &stage : pipeline.stages()) {
+        switch (stage.kind) {
+        case FilterPipeline::Stage::Lut: out = stage.lut->apply(out); break;
+        case FilterPipeline::Stage::Value: out = stage.value->apply(out); break;
+        case FilterPipeline::Stage::Convolve: out = Convolution::apply(out, stage.kernel, stage.border); break;
+        case FilterPipeline::Stage::LinearContrast: out = ImageProcessor::linearContrast(out); break;
+        case FilterPipeline::Stage::EqualizeRGB: out = ImageProcessor::equalizeRGB(out); break;
+        case FilterPipeline::Stage::EqualizeHSV: out = ImageProcessor::equalizeHSV(out); break;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+QString BenchResult::key() const
+{
+    return QString("%1/%2/%3x%4/%5").arg(operation, format).arg(size.width()).arg(size.height()).arg(threads);
+}
+
+QStringList Benchmark::operations()
+{
+    return { "contrast", "equalize-rgb", "equalize-hsv", "sharpen", "histogram" };
+}
+
+QStringList Benchmark::formatNames()
+{
+    return { "rgb32", "argb32", "grayscale8", "indexed8" };
+}
+
+QImage::Format Benchmark::format(const QString &name)
+{
+    if (name == "rgb32") return QImage::Format_RGB32;
+    if (name == "argb32") return QImage::Format_ARGB32;
+    if (name == "grayscale8") return QImage::Format_Grayscale8;
+    if (name == "indexed8") return QImage::Format_Indexed8;
+    return QImage::Format_Invalid;
+}
+
+QImage Benchmark::synthetic(const QSize &size, QImage::Format format)
+{
+    QImage img(size, format);
+    if (img.isNull()) return img;
+    const int w = size.width();
+    const int h = size.height();
+
+    if (format == QImage::Format_Indexed8) {
+        QVector<QRgb> colors(256);
+        for (int i = 0; i < 256; ++i) colors[i] = 0xff000000u | (hash(i, 7) & 0xffffffu);
+        img.setColorTable(colors);
+    }
+
+    for (int y = 0; y < h; ++y) {
+        uchar *line = img.scanLine(y);
+        const int gy = y * 255 / qMax(1, h - 1);
+        for (int x = 0; x < w; ++x) {
+            const quint32 noise = hash(x, y);
+            const int gx = x * 255 / qMax(1, w - 1);
+            // Градиент с шумом ±16: гистограмма не вырождена, и у резкости есть что усиливать
+            const int r = qBound(0, gx + int(noise & 31) - 16, 255);
+            const int g = qBound(0, gy + int((noise >> 5) & 31) - 16, 255);
+            const int b = int((noise >> 10) & 255);
+            switch (format) {
+            case QImage::Format_RGB32:
+                reinterpret_cast<QRgb *>(line)[x] = qRgb(r, g, b);
+                break;
+            case QImage::Format_ARGB32:
+                reinterpret_cast<QRgb *>(line)[x] = qRgba(r, g, b, 128 + int((noise >> 18) & 127));
+                break;
+            case QImage::Format_Grayscale8:
+                line[x] = uchar((r + g) / 2);
+                break;
+            default:
+                line[x] = uchar(noise >> 24);
+                break;
+            }
+        }
+    }
+    return img;
+}
+
+BenchResult Benchmark::measure(const QString &operation, const QImage &img, int threads,
+                               double minSeconds, int minRepeats)
+{
+    TileExecutor::global().setThreadCount(threads);
+
+    const QImage input = operation == "contrast" ? compressedRange(img) : img;
+    qint64 outputBytes = 0;
+    const auto runOnce = [&] {
+        QImage out;
+        if (operation == "contrast") out = ImageProcessor::linearContrast(input);
+        else if (operation == "equalize-rgb") out = ImageProcessor::equalizeRGB(input);
+        else if (operation == "equalize-hsv") out = ImageProcessor::equalizeHSV(input);
+        else if (operation == "sharpen") out = ImageProcessor::sharpen(input);
+        else ImageHistogram::compute(input);
+        // Операция, вернувшая вход без изменений, ничего не записала
+        outputBytes = out.isNull() || out.constBits() == input.constBits() ? 0 : out.sizeInBytes();
+    };
+
+    BenchResult result;
+    result.operation = operation;
+    result.size = img.size();
+    result.threads = TileExecutor::global().threadCount();
+
+    runOnce();      // прогрев: страницы памяти, таблицы, потоки пула
+
+    QVector<qint64> times;
+    QElapsedTimer total;
+    total.start();
+    while (times.size() < kMaxRepeats && (times.size() < minRepeats || total.nsecsElapsed() < minSeconds * 1e9)) {
+        QElapsedTimer timer;
+        timer.start();
+        runOnce();
+        times.append(timer.nsecsElapsed());
+    }
+
+    std::sort(times.begin(), times.end());
+    result.repeats = times.size();
+    result.medianNs = times[times.size() / 2];
+    result.bytes = input.sizeInBytes() + outputBytes;
+    return result;
+}
+
+QJsonObject Benchmark::toJson(const QVector<BenchResult> &results)
+{
+    QJsonArray rows;
+    for (const BenchResult &r : results) {
+        QJsonObject row;
+        row["operation"] = r.operation;
+        row["format"] = r.format;
+        row["width"] = r.size.width();
+        row["height"] = r.size.height();
+        row["threads"] = r.threads;
+        row["repeats"] = r.repeats;
+        row["medianNs"] = r.medianNs;
+        row["bytes"] = r.bytes;
+        row["nsPerPixel"] = r.nsPerPixel();
+        row["gbPerSecond"] = r.gbPerSecond();
+        if (r.speedup > 0) row["speedup"] = r.speedup;
+        rows.append(row);
+    }
+
+    QJsonObject json;
+    json["isa"] = isaJson();
+    json["results"] = rows;
+    return json;
+}
+
+QVector<BenchResult> Benchmark::fromJson(const QJsonObject &json)
+{
+    QVector<BenchResult> results;
+    for (const QJsonValue &value : json["results"].toArray()) {
+        const QJsonObject row = value.toObject();
+        BenchResult r;
+        r.operation = row["operation"].toString();
+        r.format = row["format"].toString();
+        r.size = QSize(row["width"].toInt(), row["height"].toInt());
+        r.threads = row["threads"].toInt();
+        r.repeats = row["repeats"].toInt();
+        r.medianNs = row["medianNs"].toInteger();
+        r.bytes = row["bytes"].toInteger();
+        r.speedup = row["speedup"].toDouble();
+        results.append(r);
+    }
+    return results;
+}
+
+QStringList Benchmark::isaLevels()
+{
+    const CpuFeatures &cpu = cpuFeatures();
+    QStringList levels{ "scalar" };
+    if (cpu.sse2) levels << "sse2";
+    if (cpu.ssse3) levels << "ssse3";
+    if (cpu.avx2) levels << "avx2";
+    if (cpu.avx512bw) levels << "avx512";
+    return levels;
+}
+
+QJsonObject Benchmark::verify()
+{
+    QRandomGenerator rng(kVerifySeed);
+    const ChannelLut lut(randomTable(rng), randomTable(rng), randomTable(rng));
+    const ValueLut value(randomTable(rng));
+    const ConvolutionKernel emboss(3, 3, { -2, -1, 0, -1, 1, 1, 0, 1, 2 });
+    const ConvolutionKernel binomial = ConvolutionKernel::separable({ 1, 4, 6, 4, 1 }, { 1, 4, 6, 4, 1 }, 4, 4);
+    const ConvolutionKernel gauss = ConvolutionKernel::fromReal(
+        5, 5, { 1, 4, 7, 4, 1, 4, 16, 26, 16, 4, 7, 26, 41, 26, 7, 4, 16, 26, 16, 4, 1, 4, 7, 4, 1 });
+
+    using Operation = std::function<QImage(const QImage &)>;
+    const QVector<QPair<QString, Operation>> operations = {
+        { "sharpen", [](const QImage &img) { return ImageProcessor::sharpen(img); } },
+        { "emboss-wrap", [&](const QImage &img) { return Convolution::apply(img, emboss, BorderMode::Wrap); } },
+        { "binomial-mirror", [&](const QImage &img) { return Convolution::apply(img, binomial, BorderMode::Mirror); } },
+        { "gauss-clamp", [&](const QImage &img) { return Convolution::apply(img, gauss, BorderMode::Clamp); } },
+        { "lut", [&](const QImage &img) { return lut.apply(img); } },
+        { "contrast", [](const QImage &img) { return ImageProcessor::linearContrast(img); } },
+        { "equalize-rgb", [](const QImage &img) { return ImageProcessor::equalizeRGB(img); } },
+        { "value", [&](const QImage &img) { return value.apply(img); } },
+        { "equalize-hsv", [](const QImage &img) { return ImageProcessor::equalizeHSV(img); } },
+    };
+    const QVector<QPair<QString, FilterPipeline>> pipelines = {
+        { "chain-contrast-sharpen-hsv", FilterPipeline().linearContrast().sharpen().equalizeHSV() },
+        { "chain-rgb-lut-sharpen-value", FilterPipeline().equalizeRGB().lut(lut).sharpen().value(value) },
+        { "chain-sharpen-binomial-contrast",
+          FilterPipeline().sharpen().convolve(binomial, BorderMode::Mirror).linearContrast() },
+        { "chain-lut-emboss-wrap", FilterPipeline().lut(lut).convolve(emboss, BorderMode::Wrap).equalizeRGB() },
+    };
+
+    QJsonObject digests;
+    QJsonArray mismatches;
+    for (const QString &formatName : formatNames()) {
+        for (const QSize &size : kVerifySizes) {
+            const QImage img = randomImage(rng, size, format(formatName));
+            const QString suffix = QString("/%1/%2x%3").arg(formatName).arg(size.width()).arg(size.height());
+            for (const auto &op : operations) digests[op.first + suffix] = digest(op.second(img));
+            for (const auto &chain : pipelines) {
+                const QImage fused = chain.second.run(img);
+                digests[chain.first + suffix] = digest(fused);
+                // Формат результата может отличаться (тождественная стадия возвращает вход) — сравниваются пиксели
+                if (fused.convertToFormat(QImage::Format_ARGB32)
+                    != runSequential(chain.second, img).convertToFormat(QImage::Format_ARGB32))
+                    mismatches.append(chain.first + suffix);
+            }
+        }
+    }
+
+    QJsonObject json;
+    json["isa"] = isaJson();
+    json["digests"] = digests;
+    json["mismatches"] = mismatches;
+    return json;
+}
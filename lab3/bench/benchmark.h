@@ -0,0 +1,56 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QImage>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct BenchResult {
+    QString operation;
+    QString format;
+    QSize size;
+    int threads = 0;
+    int repeats = 0;
+    qint64 medianNs = 0;
+    qint64 bytes = 0;           // прочитано и записано за один прогон
+    double speedup = 0;         // относительно одного потока, 0 — не измерялось
+
+    double megapixels() const { return double(size.width()) * size.height() / 1e6; }
+    double nsPerPixel() const { return double(medianNs) / (double(size.width()) * size.height()); }
+    double gbPerSecond() const { return medianNs > 0 ? double(bytes) / medianNs : 0; }
+    // Ключ для сравнения с сохранённым прогоном
+    QString key() const;
+};
+
+// Замеры операций ImageProcessor и гистограммы на синтетических изображениях.
+// Время — медиана повторов (не меньше minRepeats и не короче minSeconds
+// в сумме) после одного прогрева; потоки задаются через TileExecutor::global().
+class Benchmark {
+public:
+    static QStringList operations();            // contrast, equalize-rgb, equalize-hsv, sharpen, histogram
+    static QStringList formatNames();           // rgb32, argb32, grayscale8, indexed8
+    static QImage::Format format(const QString &name);
+
+    // Детерминированное изображение: градиенты с шумом, в indexed8 — 256 цветов.
+    // Для "contrast" measure() сжимает его каналы в 32..223, иначе растягивать нечего
+    static QImage synthetic(const QSize &size, QImage::Format format);
+
+    static BenchResult measure(const QString &operation, const QImage &img, int threads,
+                               double minSeconds, int minRepeats);
+
+    static QJsonObject toJson(const QVector<BenchResult> &results);
+    static QVector<BenchResult> fromJson(const QJsonObject &json);
+
+    // Проверка совпадения до бита. Операции (свёртки, таблицы, яркость HSV,
+    // цепочки FilterPipeline) прогоняются на случайных изображениях с
+    // фиксированным зерном; "digests" — хэши результатов для сравнения между
+    // процессами с разным IMAGEPROCESSOR_ISA, "mismatches" — случаи, где
+    // слитая цепочка разошлась с последовательным применением своих стадий
+    static QJsonObject verify();
+    // Значения --isa от scalar до самого широкого набора этого процессора
+    static QStringList isaLevels();
+};
+
+#endif // BENCHMARK_H
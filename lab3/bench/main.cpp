@@ -0,0 +1,252 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+#include <cmath>
+#include "benchmark.h"
+#include "channellut.h"
+#include "convolution.h"
+#include "cpufeatures.h"
+#include "valuelut.h"
+
+static QStringList splitList(const QString &value)
+{
+    QStringList result;
+    for (const QString &item : value.split(',', Qt::SkipEmptyParts)) result.append(item.trimmed().toLower());
+    return result;
+}
+
+// 4:3, как у большинства снимков и сканов
+static QSize sizeForMegapixels(double megapixels)
+{
+    const int w = qMax(1, int(std::lround(std::sqrt(megapixels * 1e6 * 4.0 / 3.0))));
+    return QSize(w, qMax(1, int(std::lround(w * 3.0 / 4.0))));
+}
+
+// 1, 2, 4, ... и число ядер
+static QString defaultThreads()
+{
+    const int cores = qMax(1, QThread::idealThreadCount());
+    QStringList result;
+    for (int n = 1; n < cores; n *= 2) result.append(QString::number(n));
+    result.append(QString::number(cores));
+    return result.join(',');
+}
+
+static bool readBaseline(const QString &fileName, QHash<QString, BenchResult> *baseline, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        *error = QString("%1: %2").arg(fileName, parseError.errorString());
+        return false;
+    }
+    for (const BenchResult &r : Benchmark::fromJson(doc.object())) baseline->insert(r.key(), r);
+    return true;
+}
+
+// Этот же исполняемый файл с --isa level --verify-child: набор инструкций выбирается
+// один раз на процесс, поэтому каждый уровень проверяется в своём процессе
+static bool verifyChild(const QString &isa, QJsonObject *result, QString *error)
+{
+    QProcess child;
+    child.start(QCoreApplication::applicationFilePath(), { "--isa", isa, "--verify-child" });
+    if (!child.waitForFinished(-1) || child.exitStatus() != QProcess::NormalExit || child.exitCode() != 0) {
+        *error = QString("%1: проверка завершилась с ошибкой %2").arg(isa, child.errorString());
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(child.readAllStandardOutput());
+    if (!doc.isObject()) {
+        *error = QString("%1: неверный ответ проверки").arg(isa);
+        return false;
+    }
+    *result = doc.object();
+    return true;
+}
+
+// Результаты каждого набора инструкций сравниваются со скалярным
+static int verifyIsaLevels(QTextStream &out, QTextStream &err)
+{
+    QJsonObject reference;
+    int failures = 0;
+    for (const QString &isa : Benchmark::isaLevels()) {
+        QJsonObject result;
+        QString error;
+        if (!verifyChild(isa, &result, &error)) {
+            err << error << Qt::endl;
+            return 1;
+        }
+        const QJsonObject digests = result["digests"].toObject();
+        const QJsonObject used = result["isa"].toObject();
+        out << QString("%1: свёртка %2, таблицы %3, яркость HSV %4, случаев %5")
+                   .arg(isa, -7).arg(used["convolution"].toString(), used["channelLut"].toString(),
+                                     used["valueLut"].toString()).arg(digests.size())
+            << Qt::endl;
+
+        if (reference.isEmpty()) reference = digests;
+        for (auto it = reference.constBegin(); it != reference.constEnd(); ++it) {
+            if (digests.value(it.key()) == it.value()) continue;
+            out << "  отличается от scalar: " << it.key() << Qt::endl;
+            ++failures;
+        }
+        for (const QJsonValue &key : result["mismatches"].toArray()) {
+            out << "  цепочка не совпала с последовательным применением: " << key.toString() << Qt::endl;
+            ++failures;
+        }
+    }
+    if (failures > 0) {
+        out << "Расхождений: " << failures << Qt::endl;
+        return 4;
+    }
+    out << "Все результаты совпадают до бита" << Qt::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("imagebench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Замеры скорости операций обработки изображений (лабораторная работа 3)");
+    parser.addHelpOption();
+
+    QCommandLineOption opsOption("ops", "Операции: " + Benchmark::operations().join(", ") + ".", "list",
+                                 Benchmark::operations().join(','));
+    QCommandLineOption formatsOption("formats", "Форматы: " + Benchmark::formatNames().join(", ") + ".", "list",
+                                     Benchmark::formatNames().join(','));
+    QCommandLineOption sizesOption("sizes", "Размеры в мегапикселях.", "list", "0.3,1,4,16,50,200");
+    QCommandLineOption threadsOption("threads", "Число потоков для замера масштабирования.", "list", defaultThreads());
+    QCommandLineOption timeOption("min-time", "Минимальное время замера одного случая, с.", "seconds", "0.5");
+    QCommandLineOption repeatsOption("repeats", "Минимальное число повторов.", "n", "5");
+    QCommandLineOption isaOption("isa", "Ограничить SIMD: scalar, sse2, ssse3, avx2, avx512.", "isa");
+    QCommandLineOption jsonOption("json", "Записать результаты в JSON.", "file");
+    QCommandLineOption baselineOption("baseline", "Сравнить с сохранённым JSON.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Допустимое замедление относительно базового прогона, %.", "percent", "10");
+    QCommandLineOption verifyOption("verify", "Вместо замеров проверить, что все наборы инструкций и слитые цепочки "
+                                              "дают одинаковый до бита результат.");
+    QCommandLineOption verifyChildOption("verify-child");
+    verifyChildOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOption(opsOption);
+    parser.addOption(formatsOption);
+    parser.addOption(sizesOption);
+    parser.addOption(threadsOption);
+    parser.addOption(timeOption);
+    parser.addOption(repeatsOption);
+    parser.addOption(isaOption);
+    parser.addOption(jsonOption);
+    parser.addOption(baselineOption);
+    parser.addOption(toleranceOption);
+    parser.addOption(verifyOption);
+    parser.addOption(verifyChildOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    // До первого cpuFeatures(): набор инструкций выбирается один раз
+    if (parser.isSet(isaOption)) qputenv("IMAGEPROCESSOR_ISA", parser.value(isaOption).toLatin1());
+
+    if (parser.isSet(verifyChildOption)) {
+        out << QJsonDocument(Benchmark::verify()).toJson(QJsonDocument::Compact) << Qt::endl;
+        return 0;
+    }
+    if (parser.isSet(verifyOption)) return verifyIsaLevels(out, err);
+
+    const QStringList ops = splitList(parser.value(opsOption));
+    const QStringList formats = splitList(parser.value(formatsOption));
+    for (const QString &op : ops) {
+        if (!Benchmark::operations().contains(op)) {
+            err << "Неизвестная операция: " << op << Qt::endl;
+            return 1;
+        }
+    }
+    for (const QString &name : formats) {
+        if (Benchmark::format(name) == QImage::Format_Invalid) {
+            err << "Неизвестный формат: " << name << Qt::endl;
+            return 1;
+        }
+    }
+    QVector<int> threads;
+    for (const QString &n : splitList(parser.value(threadsOption))) threads.append(qMax(1, n.toInt()));
+
+    QHash<QString, BenchResult> baseline;
+    QString error;
+    if (parser.isSet(baselineOption) && !readBaseline(parser.value(baselineOption), &baseline, &error)) {
+        err << error << Qt::endl;
+        return 1;
+    }
+    const double tolerance = parser.value(toleranceOption).toDouble();
+    const double minSeconds = parser.value(timeOption).toDouble();
+    const int minRepeats = qMax(1, parser.value(repeatsOption).toInt());
+
+    out << "CPU: " << cpuFeaturesName() << ", свёртка: " << Convolution::isaName()
+        << ", таблицы: " << ChannelLut::isaName() << ", яркость HSV: " << ValueLut::isaName() << Qt::endl;
+    out << QString("%1 %2 %3 %4 %5 %6 %7")
+               .arg("операция", -13).arg("формат", -11).arg("Мпикс", 7).arg("потоки", 7)
+               .arg("нс/пикс", 9).arg("ГБ/с", 7).arg("ускор.", 7)
+        << Qt::endl;
+
+    QVector<BenchResult> results;
+    int regressions = 0;
+    for (const QString &sizeText : splitList(parser.value(sizesOption))) {
+        const QSize size = sizeForMegapixels(sizeText.toDouble());
+        for (const QString &formatName : formats) {
+            const QImage img = Benchmark::synthetic(size, Benchmark::format(formatName));
+            if (img.isNull()) {
+                err << "Не хватает памяти для " << sizeText << " Мпикс " << formatName << Qt::endl;
+                continue;
+            }
+            for (const QString &op : ops) {
+                qint64 singleThreadNs = 0;
+                for (int n : threads) {
+                    BenchResult r = Benchmark::measure(op, img, n, minSeconds, minRepeats);
+                    r.format = formatName;
+                    if (r.threads == 1) singleThreadNs = r.medianNs;
+                    if (singleThreadNs > 0 && r.medianNs > 0) r.speedup = double(singleThreadNs) / r.medianNs;
+
+                    QString line = QString("%1 %2 %3 %4 %5 %6 %7")
+                                       .arg(op, -13).arg(formatName, -11)
+                                       .arg(r.megapixels(), 7, 'f', 1).arg(r.threads, 7)
+                                       .arg(r.nsPerPixel(), 9, 'f', 3).arg(r.gbPerSecond(), 7, 'f', 2)
+                                       .arg(r.speedup > 0 ? QString::number(r.speedup, 'f', 2) : QString("-"), 7);
+                    const auto base = baseline.constFind(r.key());
+                    if (base != baseline.constEnd() && base->medianNs > 0) {
+                        const double change = (double(r.medianNs) / base->medianNs - 1.0) * 100.0;
+                        line += QString("  %1%2%").arg(change >= 0 ? "+" : "").arg(change, 0, 'f', 1);
+                        if (change > tolerance) {
+                            line += "  ЗАМЕДЛЕНИЕ";
+                            ++regressions;
+                        }
+                    }
+                    out << line << Qt::endl;
+                    results.append(r);
+                }
+            }
+        }
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(Benchmark::toJson(results)).toJson()) < 0) {
+            err << file.errorString() << Qt::endl;
+            return 1;
+        }
+    }
+
+    if (!baseline.isEmpty()) {
+        out << "Замедлений больше " << tolerance << "%: " << regressions << Qt::endl;
+        if (regressions > 0) return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "channellut.h"
+#include "cpufeatures.h"
+#include "pixelaccess.h"
+#include "tileexecutor.h"
+#include <cstring>
+
+#if defined(IMAGEPROCESSOR_X86)
+#  include <immintrin.h>
+#endif
+
+using PixelAccess::ConstRows;
+using PixelAccess::Rows;
+
+namespace {
+
+void applyScalar(const quint32 (*shifted)[256], const QRgb *src, QRgb *dst, int from, int count)
+{
+    for (int i = from; i < count; ++i) {
+        const QRgb p = src[i];
+        dst[i] = (p & 0xff000000u) | shifted[0][qRed(p)] | shifted[1][qGreen(p)] | shifted[2][qBlue(p)];
+    }
+}
+
+// По 4 пикселя: двенадцать независимых чтений таблиц идут параллельно
+void applyUnrolled(const quint32 (*shifted)[256], const QRgb *src, QRgb *dst, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const QRgb p0 = src[i];
+        const QRgb p1 = src[i + 1];
+        const QRgb p2 = src[i + 2];
+        const QRgb p3 = src[i + 3];
+        dst[i] = (p0 & 0xff000000u) | shifted[0][qRed(p0)] | shifted[1][qGreen(p0)] | shifted[2][qBlue(p0)];
+        dst[i + 1] = (p1 & 0xff000000u) | shifted[0][qRed(p1)] | shifted[1][qGreen(p1)] | shifted[2][qBlue(p1)];
+        dst[i + 2] = (p2 & 0xff000000u) | shifted[0][qRed(p2)] | shifted[1][qGreen(p2)] | shifted[2][qBlue(p2)];
+        dst[i + 3] = (p3 & 0xff000000u) | shifted[0][qRed(p3)] | shifted[1][qGreen(p3)] | shifted[2][qBlue(p3)];
+    }
+    applyScalar(shifted, src, dst, i, count);
+}
+
+#if defined(IMAGEPROCESSOR_X86)
+
+// Каждый канал — отдельная сборка из 32-битной таблицы, где значение
+// уже стоит на своём месте, остаётся объединить по ИЛИ
+IMAGEPROCESSOR_TARGET("avx2")
+void applyGatherAvx2(const quint32 (*shifted)[256], const QRgb *src, QRgb *dst, int count)
+{
+    const __m256i byte = _mm256_set1_epi32(0xff);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000u));
+    const int *red = reinterpret_cast<const int *>(shifted[0]);
+    const int *green = reinterpret_cast<const int *>(shifted[1]);
+    const int *blue = reinterpret_cast<const int *>(shifted[2]);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const __m256i r = _mm256_i32gather_epi32(red, _mm256_and_si256(_mm256_srli_epi32(x, 16), byte), 4);
+        const __m256i g = _mm256_i32gather_epi32(green, _mm256_and_si256(_mm256_srli_epi32(x, 8), byte), 4);
+        const __m256i b = _mm256_i32gather_epi32(blue, _mm256_and_si256(x, byte), 4);
+        const __m256i out = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_and_si256(x, alpha)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+    }
+    applyScalar(shifted, src, dst, i, count);
+}
+
+#endif // IMAGEPROCESSOR_X86
+
+} // namespace
+
+ChannelLut::ChannelLut()
+{
+    for (int v = 0; v < 256; ++v) m_tables[0][v] = m_tables[1][v] = m_tables[2][v] = uchar(v);
+    build();
+}
+
+ChannelLut::ChannelLut(const QVector<uchar> &all)
+    : ChannelLut(all, all, all)
+{
+}
+
+ChannelLut::ChannelLut(const QVector<uchar> &red, const QVector<uchar> &green, const QVector<uchar> &blue)
+{
+    Q_ASSERT(red.size() == 256 && green.size() == 256 && blue.size() == 256);
+    std::memcpy(m_tables[0], red.constData(), 256);
+    std::memcpy(m_tables[1], green.constData(), 256);
+    std::memcpy(m_tables[2], blue.constData(), 256);
+    build();
+}
+
+void ChannelLut::build()
+{
+    for (int v = 0; v < 256; ++v) {
+        m_shifted[0][v] = quint32(m_tables[0][v]) << 16;
+        m_shifted[1][v] = quint32(m_tables[1][v]) << 8;
+        m_shifted[2][v] = quint32(m_tables[2][v]);
+    }
+}
+
+bool ChannelLut::isIdentity() const
+{
+    for (int c = 0; c < 3; ++c)
+        for (int v = 0; v < 256; ++v)
+            if (m_tables[c][v] != v) return false;
+    return true;
+}
+
+ChannelLut ChannelLut::then(const ChannelLut &next) const
+{
+    ChannelLut result;
+    for (int c = 0; c < 3; ++c)
+        for (int v = 0; v < 256; ++v) result.m_tables[c][v] = next.m_tables[c][m_tables[c][v]];
+    result.build();
+    return result;
+}
+
+void ChannelLut::applyRow(const QRgb *src, QRgb *dst, int count) const
+{
+#if defined(IMAGEPROCESSOR_X86)
+    if (cpuFeatures().avx2) return applyGatherAvx2(m_shifted, src, dst, count);
+#endif
+    applyUnrolled(m_shifted, src, dst, count);
+}
+
+QImage ChannelLut::apply(const QImage &img) const
+{
+    return apply(img, TileExecutor::global());
+}
+
+QImage ChannelLut::apply(const QImage &img, TileExecutor &executor) const
+{
+    if (img.isNull()) return img;
+
+    const QImage src = PixelAccess::toWorkingFormat(img);
+    QImage result = PixelAccess::createLike(src);
+    const ConstRows in(src);
+    const Rows out(result);
+    executor.forEachBand(src.size(), 0, [&](const Tile &band) {
+        for (int y = band.rect.top(); y <= band.rect.bottom(); ++y)
+            applyRow(in.row(y), out.row(y), in.width());
+    });
+    return result;
+}
+
+const char *ChannelLut::isaName()
+{
+#if defined(IMAGEPROCESSOR_X86)
+    if (cpuFeatures().avx2) return "AVX2 gather";
+#endif
+    return "scalar x4";
+}
@@ -0,0 +1,442 @@
+#include "convolution.h"
+#include "cpufeatures.h"
+#include "pixelaccess.h"
+#include "tileexecutor.h"
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#if defined(IMAGEPROCESSOR_X86)
+#  include <immintrin.h>
+#endif
+
+using PixelAccess::ConstRows;
+using PixelAccess::Rows;
+
+// ---------- Ядро ----------
+
+static int absSum(const QVector<qint16> &coefficients)
+{
+    int sum = 0;
+    for (qint16 c : coefficients) sum += std::abs(int(c));
+    return sum;
+}
+
+// Наибольшее по модулю значение после прохода со сдвигом shift
+static int passMaximum(int absCoefficientSum, int inputMaximum, int shift)
+{
+    return (absCoefficientSum * inputMaximum + (1 << shift) - 1) >> shift;
+}
+
+static bool validSize(int size)
+{
+    return size >= 1 && size <= ConvolutionKernel::kMaxSize && size % 2 == 1;
+}
+
+static bool toInt16(const QVector<int> &in, QVector<qint16> *out)
+{
+    out->clear();
+    for (int c : in) {
+        if (c < -32768 || c > 32767) return false;
+        out->append(qint16(c));
+    }
+    return true;
+}
+
+ConvolutionKernel::ConvolutionKernel(int width, int height, const QVector<int> &coefficients, int shift)
+{
+    if (!validSize(width) || !validSize(height) || coefficients.size() != width * height) return;
+    if (shift < 0 || shift > 14 || !toInt16(coefficients, &m_coefficients)) return;
+    if (absSum(m_coefficients) * 255 > 32767) return;
+
+    m_width = width;
+    m_height = height;
+    m_shift = shift;
+}
+
+ConvolutionKernel ConvolutionKernel::separable(const QVector<int> &row, const QVector<int> &column,
+                                               int rowShift, int columnShift)
+{
+    ConvolutionKernel kernel;
+    if (!validSize(row.size()) || !validSize(column.size())) return kernel;
+    if (rowShift < 0 || rowShift > 14 || columnShift < 0 || columnShift > 14) return kernel;
+    if (!toInt16(row, &kernel.m_row) || !toInt16(column, &kernel.m_column)) return kernel;
+
+    const int rowSum = absSum(kernel.m_row);
+    if (rowSum * 255 > 32767) return ConvolutionKernel();
+    if (absSum(kernel.m_column) * passMaximum(rowSum, 255, rowShift) > 32767) return ConvolutionKernel();
+
+    kernel.m_width = row.size();
+    kernel.m_height = column.size();
+    kernel.m_separable = true;
+    kernel.m_rowShift = rowShift;
+    kernel.m_shift = columnShift;
+    return kernel;
+}
+
+// Коэффициенты c·2^shift, округлённые так, что их сумма равна округлённой сумме
+// исходных: ошибка округления уходит в наибольший по модулю коэффициент
+static QVector<int> quantize(const QVector<double> &coefficients, int shift)
+{
+    QVector<int> q;
+    double sum = 0;
+    int qsum = 0, largest = 0;
+    for (int i = 0; i < coefficients.size(); ++i) {
+        const double scaled = std::ldexp(coefficients[i], shift);
+        q.append(int(std::lround(scaled)));
+        sum += scaled;
+        qsum += q.last();
+        if (std::abs(coefficients[i]) > std::abs(coefficients[largest])) largest = i;
+    }
+    if (!q.isEmpty()) q[largest] += int(std::lround(sum)) - qsum;
+    return q;
+}
+
+ConvolutionKernel ConvolutionKernel::fromReal(int width, int height, const QVector<double> &coefficients)
+{
+    for (int shift = 14; shift >= 0; --shift) {
+        const ConvolutionKernel kernel(width, height, quantize(coefficients, shift), shift);
+        if (!kernel.isNull()) return kernel;
+    }
+    return ConvolutionKernel();
+}
+
+ConvolutionKernel ConvolutionKernel::separableFromReal(const QVector<double> &row, const QVector<double> &column)
+{
+    // Сдвиг прохода по строкам не влияет на масштаб промежуточного результата,
+    // поэтому берём наибольший для строки, а затем наибольший для столбца
+    for (int rowShift = 14; rowShift >= 0; --rowShift) {
+        const QVector<int> qrow = quantize(row, rowShift);
+        if (!separable(qrow, QVector<int>(column.size(), 0), rowShift, 0).isNull()) {
+            for (int columnShift = 14; columnShift >= 0; --columnShift) {
+                const ConvolutionKernel kernel = separable(qrow, quantize(column, columnShift), rowShift, columnShift);
+                if (!kernel.isNull()) return kernel;
+            }
+            break;
+        }
+    }
+    return ConvolutionKernel();
+}
+
+// ---------- Проход по строке ----------
+
+namespace {
+
+// dst[i] = (Σ coefs[t]·taps[t][i] + округление) >> shift, i < n.
+// Значения — байты RGBA подряд (или 16-битные промежуточные), так что
+// каналы пикселя независимы и векторизуются без перестановок.
+struct RowPass {
+    const void *const *taps;    // const uchar* или const qint16* (input16)
+    const qint16 *coefs;
+    int count;
+    int shift;
+    bool input16;
+    void *dst;                  // uchar* или qint16* (output16)
+    bool output16;
+    int n;
+};
+
+using RowFunction = void (*)(const RowPass &);
+
+inline int saturate16(int v)
+{
+    return qBound(-32768, v, 32767);
+}
+
+// Эталон для хвостов строк и процессоров без SIMD: повторяет векторный
+// вариант операция в операцию (умножение, сложение с насыщением, сдвиг)
+void rowScalarFrom(const RowPass &pass, int from)
+{
+    const int round = pass.shift > 0 ? 1 << (pass.shift - 1) : 0;
+    for (int i = from; i < pass.n; ++i) {
+        int acc = 0;
+        for (int t = 0; t < pass.count; ++t) {
+            const int v = pass.input16 ? static_cast<const qint16 *>(pass.taps[t])[i]
+                                       : static_cast<const uchar *>(pass.taps[t])[i];
+            acc = saturate16(acc + pass.coefs[t] * v);
+        }
+        acc = saturate16(acc + round) >> pass.shift;
+        if (pass.output16) static_cast<qint16 *>(pass.dst)[i] = qint16(acc);
+        else static_cast<uchar *>(pass.dst)[i] = uchar(qBound(0, acc, 255));
+    }
+}
+
+void rowScalar(const RowPass &pass)
+{
+    rowScalarFrom(pass, 0);
+}
+
+#if defined(IMAGEPROCESSOR_X86)
+
+IMAGEPROCESSOR_TARGET("sse2")
+void rowSse2(const RowPass &pass)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(qint16(pass.shift > 0 ? 1 << (pass.shift - 1) : 0));
+    const __m128i shift = _mm_cvtsi32_si128(pass.shift);
+    int i = 0;
+    for (; i + 8 <= pass.n; i += 8) {
+        __m128i acc = zero;
+        for (int t = 0; t < pass.count; ++t) {
+            __m128i v;
+            if (pass.input16)
+                v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(static_cast<const qint16 *>(pass.taps[t]) + i));
+            else
+                v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(static_cast<const uchar *>(pass.taps[t]) + i)), zero);
+            acc = _mm_adds_epi16(acc, _mm_mullo_epi16(v, _mm_set1_epi16(pass.coefs[t])));
+        }
+        acc = _mm_sra_epi16(_mm_adds_epi16(acc, round), shift);
+        if (pass.output16)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(static_cast<qint16 *>(pass.dst) + i), acc);
+        else
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(static_cast<uchar *>(pass.dst) + i), _mm_packus_epi16(acc, acc));
+    }
+    rowScalarFrom(pass, i);
+}
+
+IMAGEPROCESSOR_TARGET("avx2")
+void rowAvx2(const RowPass &pass)
+{
+    const __m256i round = _mm256_set1_epi16(qint16(pass.shift > 0 ? 1 << (pass.shift - 1) : 0));
+    const __m128i shift = _mm_cvtsi32_si128(pass.shift);
+    int i = 0;
+    for (; i + 16 <= pass.n; i += 16) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int t = 0; t < pass.count; ++t) {
+            __m256i v;
+            if (pass.input16)
+                v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(static_cast<const qint16 *>(pass.taps[t]) + i));
+            else
+                v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(static_cast<const uchar *>(pass.taps[t]) + i)));
+            acc = _mm256_adds_epi16(acc, _mm256_mullo_epi16(v, _mm256_set1_epi16(pass.coefs[t])));
+        }
+        acc = _mm256_sra_epi16(_mm256_adds_epi16(acc, round), shift);
+        if (pass.output16) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(static_cast<qint16 *>(pass.dst) + i), acc);
+        } else {
+            const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(static_cast<uchar *>(pass.dst) + i), packed);
+        }
+    }
+    rowScalarFrom(pass, i);
+}
+
+IMAGEPROCESSOR_TARGET("avx512f,avx512bw")
+void rowAvx512(const RowPass &pass)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i round = _mm512_set1_epi16(qint16(pass.shift > 0 ? 1 << (pass.shift - 1) : 0));
+    const __m128i shift = _mm_cvtsi32_si128(pass.shift);
+    int i = 0;
+    for (; i + 32 <= pass.n; i += 32) {
+        __m512i acc = zero;
+        for (int t = 0; t < pass.count; ++t) {
+            __m512i v;
+            if (pass.input16)
+                v = _mm512_loadu_si512(static_cast<const qint16 *>(pass.taps[t]) + i);
+            else
+                v = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(static_cast<const uchar *>(pass.taps[t]) + i)));
+            acc = _mm512_adds_epi16(acc, _mm512_mullo_epi16(v, _mm512_set1_epi16(pass.coefs[t])));
+        }
+        acc = _mm512_sra_epi16(_mm512_adds_epi16(acc, round), shift);
+        if (pass.output16)
+            _mm512_storeu_si512(static_cast<qint16 *>(pass.dst) + i, acc);
+        else
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(static_cast<uchar *>(pass.dst) + i),
+                                _mm512_cvtusepi16_epi8(_mm512_max_epi16(acc, zero)));
+    }
+    rowScalarFrom(pass, i);
+}
+
+#endif // IMAGEPROCESSOR_X86
+
+RowFunction selectRowFunction()
+{
+#if defined(IMAGEPROCESSOR_X86)
+    const CpuFeatures &cpu = cpuFeatures();
+    if (cpu.avx512bw) return rowAvx512;
+    if (cpu.avx2) return rowAvx2;
+    if (cpu.sse2) return rowSse2;
+#endif
+    return rowScalar;
+}
+
+RowFunction rowFunction()
+{
+    static const RowFunction function = selectRowFunction();
+    return function;
+}
+
+// ---------- Полоса изображения ----------
+
+int borderIndex(int i, int n, BorderMode border)
+{
+    if (i >= 0 && i < n) return i;
+    switch (border) {
+    case BorderMode::Clamp:
+        return i < 0 ? 0 : n - 1;
+    case BorderMode::Wrap:
+        i %= n;
+        return i < 0 ? i + n : i;
+    case BorderMode::Mirror: {
+        if (n == 1) return 0;
+        const int period = 2 * (n - 1);
+        i %= period;
+        if (i < 0) i += period;
+        return i < n ? i : period - i;
+    }
+    }
+    return 0;
+}
+
+// Ненулевые коэффициенты одного прохода и их смещения в окне ядра
+struct Taps {
+    QVector<int> dx;
+    QVector<int> dy;
+    QVector<qint16> coefs;
+
+    void add(int x, int y, qint16 c)
+    {
+        if (c == 0) return;
+        dx.append(x);
+        dy.append(y);
+        coefs.append(c);
+    }
+};
+
+struct Plan {
+    int rx = 0;
+    int ry = 0;
+    bool separable = false;
+    Taps taps;          // неразделимое ядро, или проход по строкам
+    Taps columnTaps;    // проход по столбцам
+    int shift = 0;
+    int rowShift = 0;
+};
+
+Plan makePlan(const ConvolutionKernel &kernel)
+{
+    Plan plan;
+    plan.rx = kernel.radiusX();
+    plan.ry = kernel.radiusY();
+    plan.separable = kernel.isSeparable();
+    plan.shift = kernel.shift();
+    plan.rowShift = kernel.rowShift();
+    if (plan.separable) {
+        for (int x = 0; x < kernel.width(); ++x) plan.taps.add(x, 0, kernel.row()[x]);
+        for (int y = 0; y < kernel.height(); ++y) plan.columnTaps.add(0, y, kernel.column()[y]);
+    } else {
+        for (int y = 0; y < kernel.height(); ++y)
+            for (int x = 0; x < kernel.width(); ++x)
+                plan.taps.add(x, y, kernel.coefficients()[y * kernel.width() + x]);
+    }
+    return plan;
+}
+
+// Строки полосы вместе с запасом сверху и снизу копируются в буфер, расширенный
+// на радиус ядра слева и справа по правилу border; дальше проходы по строкам
+// идут без проверок границ
+void convolveBand(const Convolution::SourceRow &row, int w, int h, int top, int count,
+                  const Convolution::TargetRow &target, const Plan &plan, BorderMode border, bool opaque)
+{
+    const int pw = w + 2 * plan.rx;
+    const int rows = count + 2 * plan.ry;
+    const int n = w * 4;
+    const RowFunction pass = rowFunction();
+
+    std::vector<quint32> padded(size_t(rows) * pw);
+    for (int i = 0; i < rows; ++i) {
+        const QRgb *src = row(borderIndex(top - plan.ry + i, h, border));
+        quint32 *p = padded.data() + size_t(i) * pw;
+        std::memcpy(p + plan.rx, src, size_t(w) * 4);
+        for (int j = 0; j < plan.rx; ++j) {
+            p[j] = src[borderIndex(j - plan.rx, w, border)];
+            p[plan.rx + w + j] = src[borderIndex(w + j, w, border)];
+        }
+    }
+
+    std::vector<const void *> taps(qMax(plan.taps.coefs.size(), plan.columnTaps.coefs.size()));
+    auto paddedAt = [&](int line, int column) -> const void * {
+        return padded.data() + size_t(line) * pw + column;
+    };
+
+    if (!plan.separable) {
+        const Taps &t = plan.taps;
+        for (int r = 0; r < count; ++r) {
+            for (int k = 0; k < t.coefs.size(); ++k) taps[k] = paddedAt(r + t.dy[k], t.dx[k]);
+            pass({ taps.data(), t.coefs.constData(), int(t.coefs.size()), plan.shift, false,
+                   target(top + r), false, n });
+        }
+    } else {
+        // Проход по строкам во все строки буфера, затем по столбцам
+        std::vector<qint16> horizontal(size_t(rows) * n);
+        const Taps &across = plan.taps;
+        for (int i = 0; i < rows; ++i) {
+            for (int k = 0; k < across.coefs.size(); ++k) taps[k] = paddedAt(i, across.dx[k]);
+            pass({ taps.data(), across.coefs.constData(), int(across.coefs.size()), plan.rowShift, false,
+                   horizontal.data() + size_t(i) * n, true, n });
+        }
+        const Taps &down = plan.columnTaps;
+        for (int r = 0; r < count; ++r) {
+            for (int k = 0; k < down.coefs.size(); ++k) taps[k] = horizontal.data() + size_t(r + down.dy[k]) * n;
+            pass({ taps.data(), down.coefs.constData(), int(down.coefs.size()), plan.shift, true,
+                   target(top + r), false, n });
+        }
+    }
+
+    if (opaque) {
+        for (int r = 0; r < count; ++r) {
+            QRgb *dst = target(top + r);
+            for (int x = 0; x < w; ++x) dst[x] |= 0xff000000u;
+        }
+    }
+}
+
+} // namespace
+
+// ---------- Свёртка ----------
+
+QImage Convolution::apply(const QImage &img, const ConvolutionKernel &kernel, BorderMode border)
+{
+    return apply(img, kernel, border, TileExecutor::global());
+}
+
+QImage Convolution::apply(const QImage &img, const ConvolutionKernel &kernel,
+                          BorderMode border, TileExecutor &executor)
+{
+    if (img.isNull() || kernel.isNull()) return img;
+
+    const QImage src = PixelAccess::toWorkingFormat(img);
+    QImage result = PixelAccess::createLike(src);
+    const ConstRows in(src);
+    const Rows out(result);
+    const Plan plan = makePlan(kernel);
+    const bool opaque = src.format() == QImage::Format_RGB32;
+
+    const SourceRow row = [&](int y) { return in.row(y); };
+    const TargetRow target = [&](int y) { return out.row(y); };
+    executor.forEachBand(src.size(), plan.ry, [&](const Tile &band) {
+        convolveBand(row, in.width(), in.height(), band.rect.top(), band.rect.height(), target, plan, border, opaque);
+    });
+    return result;
+}
+
+void Convolution::applyRows(const SourceRow &row, int width, int height, int top, int count,
+                            const TargetRow &target, const ConvolutionKernel &kernel,
+                            BorderMode border, bool opaque)
+{
+    if (kernel.isNull() || count <= 0) return;
+    convolveBand(row, width, height, top, count, target, makePlan(kernel), border, opaque);
+}
+
+const char *Convolution::isaName()
+{
+#if defined(IMAGEPROCESSOR_X86)
+    const RowFunction function = rowFunction();
+    if (function == rowAvx512) return "AVX-512BW";
+    if (function == rowAvx2) return "AVX2";
+    if (function == rowSse2) return "SSE2";
+#endif
+    return "scalar";
+}
@@ -0,0 +1,91 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <QImage>
+#include <QVector>
+#include <functional>
+
+class TileExecutor;
+
+// Что подставлять за краем изображения
+enum class BorderMode {
+    Clamp,      // крайний пиксель
+    Mirror,     // отражение без повтора крайнего: -1 -> 1, w -> w - 2
+    Wrap        // с противоположного края
+};
+
+// Ядро свёртки в фиксированной точке: результат = (Σ c·p + 2^(shift-1)) >> shift.
+// Все вычисления идут в 16-битных целых с насыщением, поэтому коэффициенты
+// ограничены: Σ|c|·255 должна помещаться в int16 (для разделимого ядра —
+// на каждом из двух проходов). Размеры нечётные, не больше kMaxSize,
+// якорь — центр. Ядро, не прошедшее проверку, пустое (isNull()).
+class ConvolutionKernel {
+public:
+    static constexpr int kMaxSize = 15;
+
+    ConvolutionKernel() = default;
+    // Коэффициенты построчно, width x height
+    ConvolutionKernel(int width, int height, const QVector<int> &coefficients, int shift = 0);
+
+    // Разделимое ядро column x row: сначала проход по строкам (row, rowShift),
+    // затем по столбцам (column, columnShift)
+    static ConvolutionKernel separable(const QVector<int> &row, const QVector<int> &column,
+                                       int rowShift = 0, int columnShift = 0);
+
+    // Вещественные коэффициенты переводятся в фиксированную точку с наибольшим
+    // допустимым сдвигом; сумма коэффициентов сохраняется
+    static ConvolutionKernel fromReal(int width, int height, const QVector<double> &coefficients);
+    static ConvolutionKernel separableFromReal(const QVector<double> &row, const QVector<double> &column);
+
+    bool isNull() const { return m_width == 0; }
+    bool isSeparable() const { return m_separable; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int radiusX() const { return m_width / 2; }
+    int radiusY() const { return m_height / 2; }
+
+    const QVector<qint16> &coefficients() const { return m_coefficients; }   // неразделимое
+    int shift() const { return m_shift; }
+    const QVector<qint16> &row() const { return m_row; }                     // разделимое
+    const QVector<qint16> &column() const { return m_column; }
+    int rowShift() const { return m_rowShift; }
+    int columnShift() const { return m_shift; }
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    bool m_separable = false;
+    QVector<qint16> m_coefficients;
+    QVector<qint16> m_row;
+    QVector<qint16> m_column;
+    int m_shift = 0;
+    int m_rowShift = 0;
+};
+
+// Свёртка 8-битных RGBA-изображений. Строки обрабатываются ядрами SSE2 / AVX2 /
+// AVX-512BW, выбранными по cpuFeatures(); все варианты, включая скалярный,
+// дают одинаковый результат до бита. Альфа-канал сворачивается вместе с
+// цветом, у RGB32 остаётся непрозрачным.
+class Convolution {
+public:
+    static QImage apply(const QImage &img, const ConvolutionKernel &kernel,
+                        BorderMode border = BorderMode::Clamp);
+    static QImage apply(const QImage &img, const ConvolutionKernel &kernel,
+                        BorderMode border, TileExecutor &executor);
+
+    // Свёртка части изображения, которое целиком в памяти может и не лежать:
+    // строки результата [top, top + count) изображения width x height.
+    // row(y) отдаёт входную строку для y из [0, height) — вызывается только
+    // для строк в пределах радиуса ядра (после правила border), target(y) —
+    // куда писать строку результата. opaque — принудительно непрозрачная альфа.
+    using SourceRow = std::function<const QRgb *(int y)>;
+    using TargetRow = std::function<QRgb *(int y)>;
+    static void applyRows(const SourceRow &row, int width, int height, int top, int count,
+                          const TargetRow &target, const ConvolutionKernel &kernel,
+                          BorderMode border, bool opaque);
+
+    // Набор инструкций, которым считаются строки
+    static const char *isaName();
+};
+
+#endif // CONVOLUTION_H
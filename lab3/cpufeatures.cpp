@@ -0,0 +1,92 @@
+#include "cpufeatures.h"
+#include <QByteArray>
+#include <QtGlobal>
+
+#if defined(IMAGEPROCESSOR_X86)
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+#if defined(IMAGEPROCESSOR_X86)
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+{
+#  if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, int(leaf), int(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = unsigned(r[i]);
+#  else
+    if (leaf > __get_cpuid_max(0, nullptr)) {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        return;
+    }
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+}
+
+// Какие регистры ОС сохраняет при переключении потоков (XCR0)
+static quint64 enabledStateMask()
+{
+#  if defined(_MSC_VER)
+    return _xgetbv(0);
+#  else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (quint64(edx) << 32) | eax;
+#  endif
+}
+
+static CpuFeatures detect()
+{
+    CpuFeatures f;
+    unsigned r1[4], r7[4];
+    cpuid(1, 0, r1);
+    cpuid(7, 0, r7);
+
+    f.sse2 = r1[3] & (1u << 26);
+    f.ssse3 = r1[2] & (1u << 9);
+
+    const bool osxsave = r1[2] & (1u << 27);
+    const quint64 xcr0 = osxsave ? enabledStateMask() : 0;
+    const bool ymm = (xcr0 & 0x6) == 0x6;                 // SSE + AVX
+    const bool zmm = (xcr0 & 0xe6) == 0xe6;               // + opmask и верхние ZMM
+
+    f.avx2 = ymm && (r1[2] & (1u << 28)) && (r7[1] & (1u << 5));
+    f.avx512bw = f.avx2 && zmm && (r7[1] & (1u << 16)) && (r7[1] & (1u << 30));
+    return f;
+}
+#else
+static CpuFeatures detect()
+{
+    return CpuFeatures();
+}
+#endif
+
+static CpuFeatures limited(CpuFeatures f)
+{
+    const QByteArray limit = qgetenv("IMAGEPROCESSOR_ISA").toLower();
+    if (limit.isEmpty()) return f;
+    if (limit == "scalar") f.sse2 = false;
+    if (limit == "scalar" || limit == "sse2") f.ssse3 = false;
+    if (limit == "scalar" || limit == "sse2" || limit == "ssse3") f.avx2 = false;
+    if (limit != "avx512") f.avx512bw = false;
+    return f;
+}
+
+const CpuFeatures &cpuFeatures()
+{
+    static const CpuFeatures features = limited(detect());
+    return features;
+}
+
+const char *cpuFeaturesName()
+{
+    const CpuFeatures &f = cpuFeatures();
+    if (f.avx512bw) return "AVX-512BW";
+    if (f.avx2) return "AVX2";
+    if (f.ssse3) return "SSSE3";
+    if (f.sse2) return "SSE2";
+    return "scalar";
+}
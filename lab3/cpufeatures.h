@@ -0,0 +1,38 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define IMAGEPROCESSOR_X86 1
+#endif
+
+// Функции с ядрами под конкретный набор инструкций компилируются без
+// глобальных -mavx2 и т.п.: GCC/Clang получают атрибут target, MSVC
+// разрешает интринсики и так. Вызываются только после проверки cpuFeatures().
+#if defined(__GNUC__) || defined(__clang__)
+#  define IMAGEPROCESSOR_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define IMAGEPROCESSOR_TARGET(isa)
+#endif
+
+// MinGW-w64 GCC не выравнивает стек Win64 под 32- и 64-байтные переменные
+// (GCC PR 54412), а сохраняет __m256i/__m512i на стек выровненной командой.
+// Поэтому .pro собирают его с -Wa,-muse-unaligned-vector-move: ассемблер
+// заменяет такие команды невыровненными, и ядра AVX работают как везде.
+
+// Наборы инструкций процессора, которые умеют использовать фильтры.
+// Определяются один раз через CPUID (с проверкой, что ОС сохраняет
+// регистры AVX). Переменная окружения IMAGEPROCESSOR_ISA=scalar|sse2|ssse3|avx2|avx512
+// ограничивает выбор сверху — для сравнения реализаций.
+struct CpuFeatures {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool avx2 = false;
+    bool avx512bw = false;      // AVX-512F + BW: 16-битные операции в 512-битных регистрах
+};
+
+const CpuFeatures &cpuFeatures();
+
+// Самый широкий доступный набор: "AVX-512BW", "AVX2", "SSSE3", "SSE2" или "scalar"
+const char *cpuFeaturesName();
+
+#endif // CPUFEATURES_H
@@ -0,0 +1,112 @@
+#include "displaycache.h"
+#include "pixelaccess.h"
+#include <QPainter>
+#include <algorithm>
+
+using PixelAccess::ConstRows;
+using PixelAccess::Rows;
+
+void DisplayCache::setImage(const QImage &img, const ImageHistogram &histogram)
+{
+    // То же изображение (общие данные QImage) — всё посчитанное остаётся верным
+    if (!img.isNull() && img.cacheKey() == m_cacheKey && !m_levels.isEmpty()) {
+        // Гистограмма полного изображения вместо посчитанной по копии
+        if (!histogram.isNull() && histogram.pixelCount() != m_histogram.pixelCount()) {
+            m_histogram = histogram;
+            m_histogramVersion = 0;
+        }
+        return;
+    }
+
+    ++m_version;
+    m_levels.clear();
+    m_histogram = histogram;
+    m_cacheKey = img.cacheKey();
+    if (!img.isNull()) m_levels.append(PixelAccess::toWorkingFormat(img));
+}
+
+void DisplayCache::clear()
+{
+    setImage(QImage());
+}
+
+QPixmap DisplayCache::pixmap(const QSize &target)
+{
+    if (isNull() || target.isEmpty()) return QPixmap();
+    if (m_pixmapVersion == m_version && m_pixmapTarget == target) return m_pixmap;
+
+    const QSize fitted = m_levels[0].size().scaled(target, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+    const QImage &level = levelFor(fitted);
+    m_pixmap = QPixmap::fromImage(level.size() == fitted
+                                      ? level
+                                      : level.scaled(fitted, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    m_pixmapTarget = target;
+    m_pixmapVersion = m_version;
+    return m_pixmap;
+}
+
+QPixmap DisplayCache::histogramPixmap()
+{
+    if (isNull()) return QPixmap();
+    if (m_histogramVersion == m_version) return m_histogramPixmap;
+
+    if (!m_histogram.has(ImageHistogram::Luma))
+        m_histogram = ImageHistogram::compute(m_levels[0], ImageHistogram::bit(ImageHistogram::Luma));
+    const QVector<qint64> &hist = m_histogram.channel(ImageHistogram::Luma);
+
+    qint64 maxVal = *std::max_element(hist.begin(), hist.end());
+    if (maxVal == 0) maxVal = 1;
+
+    QPixmap pix(256, 120);
+    pix.fill(Qt::white);
+    QPainter p(&pix);
+    p.setPen(Qt::black);
+    for (int i = 0; i < 256; ++i) {
+        int h = int(hist[i] * 100 / maxVal);
+        p.drawLine(i, 110, i, 110 - h);
+    }
+    p.drawRect(0, 0, pix.width()-1, pix.height()-1);
+
+    m_histogramPixmap = pix;
+    m_histogramVersion = m_version;
+    return pix;
+}
+
+const QImage &DisplayCache::levelFor(const QSize &fitted)
+{
+    // Уровни строятся по мере надобности и живут до следующего setImage()
+    int i = 0;
+    while (true) {
+        if (i + 1 == m_levels.size()) {
+            const QImage &last = m_levels[i];
+            if (last.width() / 2 < fitted.width() || last.height() / 2 < fitted.height()) return last;
+            m_levels.append(halve(last));
+        }
+        const QImage &next = m_levels[i + 1];
+        if (next.width() < fitted.width() || next.height() < fitted.height()) return m_levels[i];
+        ++i;
+    }
+}
+
+// Среднее по блокам 2×2 с округлением; нечётный последний столбец и строка отбрасываются
+QImage DisplayCache::halve(const QImage &img)
+{
+    QImage result(img.width() / 2, img.height() / 2, img.format());
+    const ConstRows in(img);
+    const Rows out(result);
+    for (int y = 0; y < out.height(); ++y) {
+        const QRgb *top = in.row(2 * y);
+        const QRgb *bottom = in.row(2 * y + 1);
+        QRgb *dst = out.row(y);
+        for (int x = 0; x < out.width(); ++x) {
+            const QRgb a = top[2 * x], b = top[2 * x + 1], c = bottom[2 * x], d = bottom[2 * x + 1];
+            // Каналы через байт: суммы четырёх 8-битных значений помещаются в 16 бит
+            const quint32 lo = (a & 0x00ff00ffu) + (b & 0x00ff00ffu) + (c & 0x00ff00ffu) + (d & 0x00ff00ffu)
+                               + 0x00020002u;
+            const quint32 hi = ((a >> 8) & 0x00ff00ffu) + ((b >> 8) & 0x00ff00ffu) + ((c >> 8) & 0x00ff00ffu)
+                               + ((d >> 8) & 0x00ff00ffu) + 0x00020002u;
+            dst[x] = ((lo >> 2) & 0x00ff00ffu) | (((hi >> 2) & 0x00ff00ffu) << 8);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef DISPLAYCACHE_H
+#define DISPLAYCACHE_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+#include "imagehistogram.h"
+
+// Всё, что нужно для показа одного изображения: пирамида уменьшенных вдвое
+// копий, гистограмма яркости и готовые QPixmap. Новое изображение
+// увеличивает version(), и всё посчитанное для прежнего перестаёт
+// действовать; повторный показ без изменений ничего не пересчитывает.
+// Для размера метки берётся ближайший не меньший уровень пирамиды, так что
+// окончательное сглаженное масштабирование уменьшает не больше чем вдвое.
+class DisplayCache {
+public:
+    // histogram — уже посчитанная гистограмма полного изображения (яркость);
+    // пустая — посчитать по img
+    void setImage(const QImage &img, const ImageHistogram &histogram = ImageHistogram());
+    void clear();
+
+    bool isNull() const { return m_levels.isEmpty(); }
+    quint64 version() const { return m_version; }
+
+    QPixmap pixmap(const QSize &target);
+    QPixmap histogramPixmap();
+
+private:
+    const QImage &levelFor(const QSize &fitted);
+    static QImage halve(const QImage &img);
+
+    quint64 m_version = 0;
+    qint64 m_cacheKey = 0;
+    QVector<QImage> m_levels;           // m_levels[0] — исходное, дальше вдвое меньше
+    ImageHistogram m_histogram;
+
+    QPixmap m_pixmap;
+    QSize m_pixmapTarget;
+    quint64 m_pixmapVersion = 0;
+    QPixmap m_histogramPixmap;
+    quint64 m_histogramVersion = 0;
+};
+
+#endif // DISPLAYCACHE_H
@@ -0,0 +1,455 @@
+#include "filterpipeline.h"
+#include "imageprocessor.h"
+#include "pixelaccess.h"
+#include "stripio.h"
+#include "tileexecutor.h"
+#include <algorithm>
+
+using PixelAccess::ConstRows;
+using PixelAccess::Rows;
+using Stage = FilterPipeline::Stage;
+
+namespace {
+
+// Два буфера полосы должны помещаться в кэш второго уровня
+constexpr qint64 kBandBytes = 256 * 1024;
+constexpr int kMinBandRows = 8;
+// Полосы файла при runStreamed(): вход и результат вместе
+constexpr qint64 kStripBytes = 64 * 1024 * 1024;
+
+// Стадия, готовая к потоковому исполнению: таблица или свёртка
+struct Step {
+    Stage::Kind kind;           // Lut, Value или Convolve
+    std::shared_ptr<const ChannelLut> lut;
+    std::shared_ptr<const ValueLut> value;
+    ConvolutionKernel kernel;
+    BorderMode border;
+
+    int radius() const { return kind == Stage::Convolve ? kernel.radiusY() : 0; }
+};
+
+// Стадии, которые проходятся полосами без записи промежуточных изображений
+using Segment = std::vector<Step>;
+
+bool needsStatistics(Stage::Kind kind)
+{
+    return kind == Stage::LinearContrast || kind == Stage::EqualizeRGB || kind == Stage::EqualizeHSV;
+}
+
+int channelsFor(Stage::Kind kind)
+{
+    switch (kind) {
+    case Stage::LinearContrast:
+        return ImageHistogram::bit(ImageHistogram::Luma);
+    case Stage::EqualizeRGB:
+        return ImageHistogram::bit(ImageHistogram::Red) | ImageHistogram::bit(ImageHistogram::Green)
+             | ImageHistogram::bit(ImageHistogram::Blue);
+    case Stage::EqualizeHSV:
+        return ImageHistogram::bit(ImageHistogram::Value);
+    default:
+        return 0;
+    }
+}
+
+// Проходов по изображению: по одному на гистограмму и итоговый
+int passCount(const std::vector<Stage> &stages)
+{
+    return 1 + int(std::count_if(stages.begin(), stages.end(), [](const Stage &stage) {
+        return needsStatistics(stage.kind);
+    }));
+}
+
+Stage tableFor(Stage::Kind kind, const ImageHistogram &hist)
+{
+    Stage stage;
+    if (kind == Stage::EqualizeHSV) {
+        stage.kind = Stage::Value;
+        stage.value = std::make_shared<const ValueLut>(ImageProcessor::equalizeHSVLut(hist));
+    } else {
+        stage.kind = Stage::Lut;
+        stage.lut = std::make_shared<const ChannelLut>(kind == Stage::LinearContrast
+                                                           ? ImageProcessor::linearContrastLut(hist)
+                                                           : ImageProcessor::equalizeRGBLut(hist));
+    }
+    return stage;
+}
+
+// Сливает подряд идущие таблицы, выбрасывает тождественные и делит цепочку
+// на сегменты перед свёртками с заворачиванием
+std::vector<Segment> plan(const std::vector<Stage> &stages)
+{
+    std::vector<Segment> segments(1);
+    for (const Stage &stage : stages) {
+        Q_ASSERT(!needsStatistics(stage.kind));
+        Segment &current = segments.back();
+        if (stage.kind == Stage::Lut && !current.empty() && current.back().kind == Stage::Lut) {
+            current.back().lut = std::make_shared<const ChannelLut>(current.back().lut->then(*stage.lut));
+            continue;
+        }
+        if (stage.kind == Stage::Convolve && stage.border == BorderMode::Wrap && !current.empty())
+            segments.emplace_back();
+        segments.back().push_back({ stage.kind, stage.lut, stage.value, stage.kernel, stage.border });
+    }
+
+    for (Segment &segment : segments) {
+        segment.erase(std::remove_if(segment.begin(), segment.end(), [](const Step &step) {
+            return step.kind == Stage::Lut && step.lut->isIdentity();
+        }), segment.end());
+    }
+    segments.erase(std::remove_if(segments.begin(), segments.end(), [](const Segment &segment) {
+        return segment.empty();
+    }), segments.end());
+    return segments;
+}
+
+int haloOf(const Segment &segment)
+{
+    int halo = 0;
+    for (const Step &step : segment) halo += step.radius();
+    return halo;
+}
+
+int bandRowsFor(int width)
+{
+    return int(qBound<qint64>(kMinBandRows, kBandBytes / (qint64(qMax(width, 1)) * 4), TileExecutor::kBandRows));
+}
+
+// Проводит полосу band через все стадии сегмента; строка y результата
+// пишется в target(y). in(y) отдаёт строку y изображения w×h и должна
+// покрывать полосу с запасом haloOf(steps) строк. Стадии i нужен вход со
+// строками запаса для всех свёрток после неё, так что каждая свёртка сужает
+// диапазон на свой радиус.
+void runBand(const Convolution::SourceRow &in, int w, int h, const Segment &steps, const QRect &band,
+             const Convolution::TargetRow &target, bool opaque)
+{
+    // Буферы живут в потоке пула и переиспользуются между полосами
+    thread_local std::vector<quint32> first;
+    thread_local std::vector<quint32> second;
+
+    const int n = int(steps.size());
+
+    std::vector<int> after(n + 1, 0);      // запас строк, нужный стадиям с i-й до конца
+    for (int i = n - 1; i >= 0; --i) after[i] = after[i + 1] + steps[i].radius();
+
+    const size_t capacity = size_t(band.height() + 2 * after[0]) * w;
+    if (first.size() < capacity) {
+        first.resize(capacity);
+        second.resize(capacity);
+    }
+
+    // Вход стадии: строки in или буфер, начинающийся со строки currentTop
+    quint32 *current = nullptr;
+    int currentTop = 0;
+    const Convolution::SourceRow source = [&](int y) -> const QRgb * {
+        return current ? current + size_t(y - currentTop) * w : in(y);
+    };
+
+    for (int i = 0; i < n; ++i) {
+        const Step &step = steps[i];
+        const bool last = i == n - 1;
+        const int top = std::max(0, band.top() - after[i + 1]);
+        const int bottom = std::min(h, band.bottom() + 1 + after[i + 1]);
+
+        // Точечная стадия пишет поверх своего входа, свёртка — в другой буфер
+        quint32 *output = nullptr;
+        int outputTop = top;
+        if (!last) {
+            if (step.kind != Stage::Convolve && current) {
+                output = current;
+                outputTop = currentTop;
+            } else {
+                output = current == first.data() ? second.data() : first.data();
+            }
+        }
+        const Convolution::TargetRow write = [&](int y) -> QRgb * {
+            return last ? target(y) : output + size_t(y - outputTop) * w;
+        };
+
+        if (step.kind == Stage::Convolve) {
+            Convolution::applyRows(source, w, h, top, bottom - top, write, step.kernel, step.border, opaque);
+        } else if (step.kind == Stage::Lut) {
+            for (int y = top; y < bottom; ++y) step.lut->applyRow(source(y), write(y), w);
+        } else {
+            for (int y = top; y < bottom; ++y) step.value->applyRow(source(y), write(y), w);
+        }
+
+        current = output;
+        currentTop = outputTop;
+    }
+
+    // Пустой сегмент: результат — сам вход
+    if (n == 0) {
+        for (int y = band.top(); y <= band.bottom(); ++y) std::copy(in(y), in(y) + w, target(y));
+    }
+}
+
+// Строки area изображения w×h через сегмент, полосами на пуле
+void runBands(const Convolution::SourceRow &in, int w, int h, const Segment &segment, const QRect &area,
+              const Convolution::TargetRow &target, bool opaque, TileExecutor &executor)
+{
+    executor.run(TileExecutor::bands(area.size(), haloOf(segment), bandRowsFor(w)), [&](const Tile &band) {
+        runBand(in, w, h, segment, band.rect.translated(area.topLeft()), target, opaque);
+    });
+}
+
+// Гистограмма строк area после сегмента: каждая полоса проходит сегмент во
+// временный буфер потока и сразу считается, результат в память не пишется
+ImageHistogram histogramBands(const Convolution::SourceRow &in, int w, int h, const Segment &segment,
+                              const QRect &area, int channels, bool opaque, TileExecutor &executor)
+{
+    const int bandRows = bandRowsFor(w);
+    return executor.mapReduce(TileExecutor::bands(area.size(), haloOf(segment), bandRows), ImageHistogram(),
+        [&](const Tile &tile) {
+            thread_local QImage buffer;
+            const QImage::Format format = opaque ? QImage::Format_RGB32 : QImage::Format_ARGB32;
+            if (buffer.width() != w || buffer.height() < bandRows || buffer.format() != format)
+                buffer = QImage(w, bandRows, format);
+            const Rows target(buffer);
+            const QRect band = tile.rect.translated(area.topLeft());
+            runBand(in, w, h, segment, band, [&](int y) { return target.row(y - band.top()); }, opaque);
+            return ImageHistogram::computeRows(buffer, 0, band.height(), channels);
+        },
+        [](ImageHistogram &acc, const ImageHistogram &part) { acc.add(part); });
+}
+
+Convolution::SourceRow rowsOf(const ConstRows &rows)
+{
+    return [rows](int y) { return rows.row(y); };
+}
+
+QImage runSegment(const QImage &in, const Segment &segment, TileExecutor &executor)
+{
+    QImage out = PixelAccess::createLike(in);
+    const Rows target(out);
+    runBands(rowsOf(ConstRows(in)), in.width(), in.height(), segment, in.rect(),
+             [&](int y) { return target.row(y); }, in.format() == QImage::Format_RGB32, executor);
+    return out;
+}
+
+QImage runSegments(const QImage &src, const std::vector<Segment> &segments, TileExecutor &executor)
+{
+    QImage current = src;
+    for (const Segment &segment : segments) current = runSegment(current, segment, executor);
+    return current;
+}
+
+// Гистограмма результата stages: всё, кроме последнего сегмента,
+// записывается, последний считается полосами без записи
+ImageHistogram histogramAfter(const QImage &src, const std::vector<Stage> &stages, int channels,
+                              TileExecutor &executor)
+{
+    std::vector<Segment> segments = plan(stages);
+    if (segments.empty()) return ImageHistogram::compute(src, channels, executor);
+
+    const Segment last = segments.back();
+    segments.pop_back();
+    const QImage in = runSegments(src, segments, executor);
+    return histogramBands(rowsOf(ConstRows(in)), in.width(), in.height(), last, in.rect(), channels,
+                          in.format() == QImage::Format_RGB32, executor);
+}
+
+// Статистические стадии по порядку получают гистограмму своего входа
+// (результата префикса) и заменяются таблицами; следующая уже видит
+// предыдущие как таблицы
+using HistogramOf = std::function<ImageHistogram(const std::vector<Stage> &prefix, int channels)>;
+
+std::vector<Stage> resolve(std::vector<Stage> stages, const HistogramOf &histogramOf)
+{
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (!needsStatistics(stages[i].kind)) continue;
+        const Stage::Kind kind = stages[i].kind;
+        const ImageHistogram hist = histogramOf(std::vector<Stage>(stages.begin(), stages.begin() + i),
+                                                channelsFor(kind));
+        stages[i] = tableFor(kind, hist);
+    }
+    return stages;
+}
+
+// Полосы файла по stripRows строк результата; полоса входа расширена на
+// halo строк с каждой стороны. fn(strip, stripTop, area) получает строки
+// входа, начиная со stripTop, и строки результата area
+bool forEachStrip(StripReader &reader, int halo, int stripRows, QString *error,
+                  const std::function<bool(const QImage &, int, const QRect &)> &fn)
+{
+    const QSize size = reader.size();
+    for (int top = 0; top < size.height(); top += stripRows) {
+        const QRect area(0, top, size.width(), qMin(stripRows, size.height() - top));
+        const int inTop = qMax(0, top - halo);
+        const int inBottom = qMin(size.height(), area.bottom() + 1 + halo);
+        const QImage strip = reader.read(inTop, inBottom - inTop, error);
+        if (strip.isNull() || !fn(strip, inTop, area)) return false;
+    }
+    return true;
+}
+
+bool cancelled(QString *error)
+{
+    *error = QString("Операция отменена");
+    return false;
+}
+
+Convolution::SourceRow stripRowsOf(const QImage &strip, int stripTop)
+{
+    const ConstRows rows(strip);
+    return [rows, stripTop](int y) { return rows.row(y - stripTop); };
+}
+
+} // namespace
+
+FilterPipeline &FilterPipeline::append(Stage stage)
+{
+    m_stages.push_back(std::move(stage));
+    return *this;
+}
+
+FilterPipeline &FilterPipeline::linearContrast()
+{
+    Stage stage;
+    stage.kind = Stage::LinearContrast;
+    return append(stage);
+}
+
+FilterPipeline &FilterPipeline::equalizeRGB()
+{
+    Stage stage;
+    stage.kind = Stage::EqualizeRGB;
+    return append(stage);
+}
+
+FilterPipeline &FilterPipeline::equalizeHSV()
+{
+    Stage stage;
+    stage.kind = Stage::EqualizeHSV;
+    return append(stage);
+}
+
+FilterPipeline &FilterPipeline::sharpen()
+{
+    return convolve(ImageProcessor::sharpenKernel(), BorderMode::Clamp);
+}
+
+FilterPipeline &FilterPipeline::lut(const ChannelLut &lut)
+{
+    Stage stage;
+    stage.kind = Stage::Lut;
+    stage.lut = std::make_shared<const ChannelLut>(lut);
+    return append(stage);
+}
+
+FilterPipeline &FilterPipeline::value(const ValueLut &lut)
+{
+    Stage stage;
+    stage.kind = Stage::Value;
+    stage.value = std::make_shared<const ValueLut>(lut);
+    return append(stage);
+}
+
+FilterPipeline &FilterPipeline::convolve(const ConvolutionKernel &kernel, BorderMode border)
+{
+    if (kernel.isNull()) return *this;
+    Stage stage;
+    stage.kind = Stage::Convolve;
+    stage.kernel = kernel;
+    stage.border = border;
+    return append(stage);
+}
+
+QImage FilterPipeline::run(const QImage &img) const
+{
+    return run(img, TileExecutor::global());
+}
+
+QImage FilterPipeline::run(const QImage &img, TileExecutor &executor) const
+{
+    if (img.isNull() || m_stages.empty()) return img;
+
+    const QImage src = PixelAccess::toWorkingFormat(img);
+    const int passes = passCount(m_stages);
+    int pass = 0;
+    const std::vector<Stage> stages = resolve(m_stages, [&](const std::vector<Stage> &prefix, int channels) {
+        executor.beginPass(pass++, passes);
+        return histogramAfter(src, prefix, channels, executor);
+    });
+    executor.beginPass(pass, passes);
+    return runSegments(src, plan(stages), executor);
+}
+
+ImageHistogram FilterPipeline::histogram(const QImage &img, int channels) const
+{
+    return histogram(img, channels, TileExecutor::global());
+}
+
+ImageHistogram FilterPipeline::histogram(const QImage &img, int channels, TileExecutor &executor) const
+{
+    if (img.isNull()) return ImageHistogram();
+
+    const QImage src = PixelAccess::toWorkingFormat(img);
+    const int passes = passCount(m_stages);
+    int pass = 0;
+    const std::vector<Stage> stages = resolve(m_stages, [&](const std::vector<Stage> &prefix, int channels) {
+        executor.beginPass(pass++, passes);
+        return histogramAfter(src, prefix, channels, executor);
+    });
+    executor.beginPass(pass, passes);
+    return histogramAfter(src, stages, channels, executor);
+}
+
+bool FilterPipeline::runStreamed(StripReader &reader, StripWriter &writer, QString *error) const
+{
+    return runStreamed(reader, writer, TileExecutor::global(), error);
+}
+
+bool FilterPipeline::runStreamed(StripReader &reader, StripWriter &writer, TileExecutor &executor,
+                                 QString *error) const
+{
+    for (const Stage &stage : m_stages) {
+        if (stage.kind == Stage::Convolve && stage.border == BorderMode::Wrap) {
+            *error = QString("Свёртка с заворачиванием краёв требует изображения целиком");
+            return false;
+        }
+    }
+
+    const int w = reader.size().width();
+    const int h = reader.size().height();
+    const bool opaque = !reader.hasAlpha();
+    // Полоса входа и полоса результата вместе укладываются в kStripBytes
+    const int stripRows = int(qMin<qint64>(h, qMax<qint64>(bandRowsFor(w), kStripBytes / (qint64(w) * 4 * 2))));
+    // Каждая полоса каждого прохода — своя доля шкалы хода
+    const int strips = stripRows > 0 ? (h + stripRows - 1) / stripRows : 1;
+    const int passes = passCount(m_stages);
+    int pass = 0;
+
+    // Без Wrap план — не больше одного сегмента
+    bool ok = true;
+    const std::vector<Stage> stages = resolve(m_stages, [&](const std::vector<Stage> &prefix, int channels) {
+        ImageHistogram hist;
+        if (!ok) return hist;
+        const std::vector<Segment> segments = plan(prefix);
+        const Segment segment = segments.empty() ? Segment() : segments.front();
+        ok = forEachStrip(reader, haloOf(segment), stripRows, error,
+                          [&](const QImage &strip, int stripTop, const QRect &area) {
+            if (executor.isCancelled()) return cancelled(error);
+            executor.beginPass(pass * strips + area.top() / stripRows, passes * strips);
+            hist.add(histogramBands(stripRowsOf(strip, stripTop), w, h, segment, area, channels, opaque, executor));
+            return true;
+        });
+        ++pass;
+        return hist;
+    });
+    if (!ok) return false;
+
+    const std::vector<Segment> segments = plan(stages);
+    const Segment segment = segments.empty() ? Segment() : segments.front();
+    QImage out;
+    return forEachStrip(reader, haloOf(segment), stripRows, error,
+                        [&](const QImage &strip, int stripTop, const QRect &area) {
+        if (executor.isCancelled()) return cancelled(error);
+        executor.beginPass(pass * strips + area.top() / stripRows, passes * strips);
+        if (out.height() != area.height())
+            out = QImage(w, area.height(), opaque ? QImage::Format_RGB32 : QImage::Format_ARGB32);
+        const Rows target(out);
+        runBands(stripRowsOf(strip, stripTop), w, h, segment, area,
+                 [&](int y) { return target.row(y - area.top()); }, opaque, executor);
+        return writer.write(out, error);
+    });
+}
@@ -0,0 +1,72 @@
+#ifndef FILTERPIPELINE_H
+#define FILTERPIPELINE_H
+
+#include <QImage>
+#include <memory>
+#include <vector>
+#include "channellut.h"
+#include "convolution.h"
+#include "imagehistogram.h"
+#include "valuelut.h"
+
+class StripReader;
+class StripWriter;
+class TileExecutor;
+
+// Цепочка фильтров, которая выполняется целиком при run(), а не по одному
+// фильтру с полной копией изображения на каждом шаге.
+//
+// Подряд идущие поканальные таблицы сливаются в одну. Остальные стадии
+// проходят изображение полосами: полоса со строками запаса для свёрток
+// проводится через все стадии в двух буферах размером с кэш, и в память
+// пишется только результат. Стадии, которым нужна гистограмма своего входа
+// (контрастирование, эквализация), сначала получают её отдельным проходом
+// по предшествующей части цепочки без записи, а затем становятся таблицами.
+// Свёртка с заворачиванием (Wrap) не первой стадией требует полного входа —
+// перед ней результат записывается целиком.
+//
+// runStreamed() обрабатывает файл, который в память не помещается: полосы
+// читаются из StripReader и пишутся в StripWriter по мере готовности, каждая
+// статистическая стадия стоит ещё одного прохода по файлу.
+class FilterPipeline {
+public:
+    struct Stage {
+        enum Kind { Lut, Value, Convolve, LinearContrast, EqualizeRGB, EqualizeHSV };
+        Kind kind;
+        std::shared_ptr<const ChannelLut> lut;
+        std::shared_ptr<const ValueLut> value;
+        ConvolutionKernel kernel;
+        BorderMode border = BorderMode::Clamp;
+    };
+
+    FilterPipeline &linearContrast();
+    FilterPipeline &equalizeRGB();
+    FilterPipeline &equalizeHSV();
+    FilterPipeline &sharpen();
+    FilterPipeline &lut(const ChannelLut &lut);
+    FilterPipeline &value(const ValueLut &lut);
+    FilterPipeline &convolve(const ConvolutionKernel &kernel, BorderMode border = BorderMode::Clamp);
+
+    bool isEmpty() const { return m_stages.empty(); }
+    int size() const { return int(m_stages.size()); }
+    const std::vector<Stage> &stages() const { return m_stages; }
+
+    QImage run(const QImage &img) const;
+    QImage run(const QImage &img, TileExecutor &executor) const;
+
+    // Гистограмма результата без его записи в память
+    ImageHistogram histogram(const QImage &img, int channels) const;
+    ImageHistogram histogram(const QImage &img, int channels, TileExecutor &executor) const;
+
+    // writer уже открыт на reader.size(); закрывает его вызывающий.
+    // Свёртки с BorderMode::Wrap здесь не поддерживаются
+    bool runStreamed(StripReader &reader, StripWriter &writer, QString *error) const;
+    bool runStreamed(StripReader &reader, StripWriter &writer, TileExecutor &executor, QString *error) const;
+
+private:
+    FilterPipeline &append(Stage stage);
+
+    std::vector<Stage> m_stages;
+};
+
+#endif // FILTERPIPELINE_H
@@ -0,0 +1,118 @@
+#include "imagehistogram.h"
+#include "pixelaccess.h"
+#include "tileexecutor.h"
+#include <algorithm>
+#include <array>
+#include <utility>
+
+using PixelAccess::ConstRows;
+
+namespace {
+
+constexpr int kLanes = 4;
+
+struct BandCounts {
+    quint32 bins[ImageHistogram::ChannelCount][kLanes][256];
+};
+
+template <int Channels>
+inline void countPixel(BandCounts &c, int lane, QRgb p)
+{
+    if (Channels & ImageHistogram::bit(ImageHistogram::Red)) c.bins[ImageHistogram::Red][lane][qRed(p)]++;
+    if (Channels & ImageHistogram::bit(ImageHistogram::Green)) c.bins[ImageHistogram::Green][lane][qGreen(p)]++;
+    if (Channels & ImageHistogram::bit(ImageHistogram::Blue)) c.bins[ImageHistogram::Blue][lane][qBlue(p)]++;
+    if (Channels & ImageHistogram::bit(ImageHistogram::Luma)) c.bins[ImageHistogram::Luma][lane][qGray(p)]++;
+    if (Channels & ImageHistogram::bit(ImageHistogram::Value))
+        c.bins[ImageHistogram::Value][lane][std::max({ qRed(p), qGreen(p), qBlue(p) })]++;
+}
+
+// Набор каналов — параметр шаблона, чтобы во внутреннем цикле не было проверок
+template <int Channels>
+void countBand(const ConstRows &in, const QRect &rect, BandCounts &c)
+{
+    const int w = in.width();
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const QRgb *line = in.row(y);
+        int x = 0;
+        for (; x + kLanes <= w; x += kLanes)
+            for (int lane = 0; lane < kLanes; ++lane) countPixel<Channels>(c, lane, line[x + lane]);
+        for (; x < w; ++x) countPixel<Channels>(c, 0, line[x]);
+    }
+}
+
+using CountFunction = void (*)(const ConstRows &, const QRect &, BandCounts &);
+
+template <std::size_t... Masks>
+constexpr std::array<CountFunction, sizeof...(Masks)> countFunctions(std::index_sequence<Masks...>)
+{
+    return {{ &countBand<int(Masks)>... }};
+}
+
+constexpr auto kCountFunctions = countFunctions(std::make_index_sequence<ImageHistogram::kAllChannels + 1>());
+
+} // namespace
+
+ImageHistogram ImageHistogram::compute(const QImage &img, int channels)
+{
+    return compute(img, channels, TileExecutor::global());
+}
+
+ImageHistogram ImageHistogram::compute(const QImage &img, int channels, TileExecutor &executor)
+{
+    if (img.isNull()) return ImageHistogram();
+
+    const QImage src = PixelAccess::toWorkingFormat(img);
+    return executor.mapReduce(TileExecutor::bands(src.size()), ImageHistogram(),
+        [&](const Tile &band) { return computeRows(src, band.rect.top(), band.rect.height(), channels); },
+        [](ImageHistogram &acc, const ImageHistogram &part) { acc.add(part); });
+}
+
+ImageHistogram ImageHistogram::computeRows(const QImage &img, int top, int count, int channels)
+{
+    ImageHistogram result;
+    channels &= kAllChannels;
+    if (channels == 0 || count <= 0) return result;
+
+    const ConstRows in(img);
+    BandCounts counts = {};
+    kCountFunctions[channels](in, QRect(0, top, in.width(), count), counts);
+
+    result.m_channels = channels;
+    result.m_pixels = qint64(in.width()) * count;
+    for (int c = 0; c < ChannelCount; ++c) {
+        if (!(channels & (1 << c))) continue;
+        QVector<qint64> &bins = result.m_bins[c];
+        bins.fill(0, 256);
+        for (int lane = 0; lane < kLanes; ++lane)
+            for (int v = 0; v < 256; ++v) bins[v] += counts.bins[c][lane][v];
+    }
+    return result;
+}
+
+void ImageHistogram::add(const ImageHistogram &other)
+{
+    for (int c = 0; c < ChannelCount; ++c) {
+        if (!other.has(Channel(c))) continue;
+        QVector<qint64> &bins = m_bins[c];
+        if (bins.isEmpty()) bins.fill(0, 256);
+        for (int v = 0; v < 256; ++v) bins[v] += other.m_bins[c][v];
+    }
+    m_channels |= other.m_channels;
+    m_pixels += other.m_pixels;
+}
+
+int ImageHistogram::minimum(Channel c) const
+{
+    const QVector<qint64> &bins = m_bins[c];
+    for (int v = 0; v < bins.size(); ++v)
+        if (bins[v] > 0) return v;
+    return -1;
+}
+
+int ImageHistogram::maximum(Channel c) const
+{
+    const QVector<qint64> &bins = m_bins[c];
+    for (int v = int(bins.size()) - 1; v >= 0; --v)
+        if (bins[v] > 0) return v;
+    return -1;
+}
@@ -0,0 +1,48 @@
+#ifndef IMAGEHISTOGRAM_H
+#define IMAGEHISTOGRAM_H
+
+#include <QImage>
+#include <QVector>
+
+class TileExecutor;
+
+// Гистограммы нескольких каналов изображения за один проход.
+// Каждая полоса TileExecutor считает в собственные 32-битные счётчики,
+// разбитые на 4 дорожки по номеру пикселя: соседние пиксели одного цвета
+// увеличивают разные ячейки и не ждут друг друга (store-to-load). Дорожки
+// и полосы складываются в 64-битные итоги в конце.
+class ImageHistogram {
+public:
+    // Luma — qGray(), Value — V модели HSV, max(R, G, B)
+    enum Channel { Red, Green, Blue, Luma, Value, ChannelCount };
+
+    static constexpr int kAllChannels = (1 << ChannelCount) - 1;
+    static constexpr int bit(Channel c) { return 1 << c; }
+
+    ImageHistogram() = default;
+
+    // channels — маска из bit(...)
+    static ImageHistogram compute(const QImage &img, int channels = kAllChannels);
+    static ImageHistogram compute(const QImage &img, int channels, TileExecutor &executor);
+
+    // Строки [top, top + count) изображения в рабочем формате PixelAccess,
+    // в вызывающем потоке — для тех, кто сам делит изображение на части
+    static ImageHistogram computeRows(const QImage &img, int top, int count, int channels);
+    void add(const ImageHistogram &other);
+
+    bool isNull() const { return m_pixels == 0; }
+    bool has(Channel c) const { return m_channels & bit(c); }
+    qint64 pixelCount() const { return m_pixels; }
+    const QVector<qint64> &channel(Channel c) const { return m_bins[c]; }
+
+    // Наименьшее и наибольшее встретившееся значение, -1 для пустой гистограммы
+    int minimum(Channel c) const;
+    int maximum(Channel c) const;
+
+private:
+    int m_channels = 0;
+    qint64 m_pixels = 0;
+    QVector<qint64> m_bins[ChannelCount];
+};
+
+#endif // IMAGEHISTOGRAM_H
@@ -3,6 +3,10 @@
 
 #include <QImage>
 #include <QVector>
+#include "channellut.h"
+#include "convolution.h"
+#include "imagehistogram.h"
+#include "valuelut.h"
 
 class ImageProcessor {
 public:
@@ -11,9 +15,14 @@ public:
     static QImage equalizeHSV(const QImage& img);
     static QImage sharpen(const QImage& img);
 
+    // Те же фильтры как точечные операции по гистограмме входа (FilterPipeline)
+    static ChannelLut linearContrastLut(const ImageHistogram& hist);    // канал Luma
+    static ChannelLut equalizeRGBLut(const ImageHistogram& hist);       // Red, Green, Blue
+    static ValueLut equalizeHSVLut(const ImageHistogram& hist);         // Value
+    static ConvolutionKernel sharpenKernel();
+
 private:
-    static QVector<int> computeHistogram(const QImage& img, int channel);
-    static QVector<uchar> computeEqualizationLUT(const QVector<int>& hist, int totalPixels);
+    static QVector<uchar> computeEqualizationLUT(const QVector<qint64>& hist, qint64 totalPixels);
 };
 
 #endif // IMAGEPROCESSOR_H
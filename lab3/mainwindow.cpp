@@ -1,21 +1,37 @@
 #include "mainwindow.h"
+#include "filterpipeline.h"
+#include "imagehistogram.h"
 #include "imageprocessor.h"
+#include "stripio.h"
 #include <QFileDialog>
+#include <QImageReader>
+#include <QMessageBox>
+#include <QMetaObject>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
-#include <QPainter>
 #include <QPixmap>
 #include <QFrame>
-#include <algorithm>
+
+// Больше — файл обрабатывается полосами, а на экране его уменьшенная копия
+static const qint64 kMaxInteractivePixels = 64 * 1024 * 1024;
+static const int kPreviewSide = 2048;
+// Большая сторона копии, на которой фильтр считается для мгновенного показа
+static const int kProxySide = 1600;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
+    jobPool.setMaxThreadCount(1);       // внутри задания фильтры и так параллельны
     setupUI();
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow()
+{
+    if (jobControl) jobControl->cancel();
+    jobPool.clear();
+    jobPool.waitForDone();
+}
 
 void MainWindow::setupUI()
 {
@@ -39,12 +55,20 @@ void MainWindow::setupUI()
     btnLinear = new QPushButton("Линейное контрастирование");
     btnEqualize = new QPushButton("Эквализация гистограммы");
     btnSharpen = new QPushButton("Повышение резкости");
+    btnCancel = new QPushButton("Отмена");
+
+    progressBar = new QProgressBar();
+    progressBar->setTextVisible(false);
+    progressBar->hide();
+    btnCancel->hide();
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(100);
 
     comboMode = new QComboBox();
     comboMode->addItem("RGB (каждая компонента)");
     comboMode->addItem("HSV (только яркость)");
 
-    QList<QWidget*> controls = {btnLoad, btnSave, btnLinear, btnEqualize, comboMode, btnSharpen};
+    QList<QWidget*> controls = {btnLoad, btnSave, btnLinear, btnEqualize, comboMode, btnSharpen, btnCancel};
     for (auto w : controls) {
         w->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
         w->setStyleSheet(
@@ -81,10 +105,15 @@ void MainWindow::setupUI()
     buttonLayout->addWidget(btnSharpen);
     buttonLayout->setSpacing(10);
 
+    QHBoxLayout *progressLayout = new QHBoxLayout();
+    progressLayout->addWidget(progressBar, 1);
+    progressLayout->addWidget(btnCancel);
+
     QVBoxLayout *mainLayout = new QVBoxLayout();
     mainLayout->addLayout(gridLayout);
     mainLayout->addSpacing(15);
     mainLayout->addLayout(buttonLayout);
+    mainLayout->addLayout(progressLayout);
     mainLayout->setContentsMargins(15, 15, 15, 15);
 
     central->setLayout(mainLayout);
@@ -94,91 +123,252 @@ void MainWindow::setupUI()
     connect(btnLinear, &QPushButton::clicked, this, &MainWindow::applyLinearContrast);
     connect(btnEqualize, &QPushButton::clicked, this, &MainWindow::applyEqualization);
     connect(btnSharpen, &QPushButton::clicked, this, &MainWindow::applySharpen);
+    connect(btnCancel, &QPushButton::clicked, this, &MainWindow::cancelJob);
+    connect(progressTimer, &QTimer::timeout, this, &MainWindow::updateProgress);
 }
 
 void MainWindow::loadImage()
 {
-    QString fileName = QFileDialog::getOpenFileName(this, "Открыть изображение", "", "Images (*.png *.jpg *.bmp *.jpeg)");
-    if (!fileName.isEmpty()) {
-        if (!originalImage.load(fileName)) return;
-        originalImage = originalImage.convertToFormat(QImage::Format_RGB32);
-        processedImage = originalImage;
-        displayImages();
+    QString fileName = QFileDialog::getOpenFileName(this, "Открыть изображение", "", "Images (*.png *.jpg *.bmp *.jpeg *.ppm *.pgm *.pam)");
+    if (fileName.isEmpty()) return;
+
+    const QSize size = QImageReader(fileName).size();
+    const bool large = fileName.endsWith(".pam", Qt::CaseInsensitive)
+                       || qint64(size.width()) * size.height() > kMaxInteractivePixels;
+    setFiltersEnabled(false);
+    runJob([this, fileName, large]() -> std::function<void()> {
+        if (large) {
+            StripReader reader;
+            QString error;
+            const QImage preview = reader.open(fileName, &error) ? reader.preview(kPreviewSide, &error) : QImage();
+            const QImage proxy = makeProxy(preview);
+            QString readError;
+            if (!preview.isNull()) reader.canRead(&readError);
+            return [this, fileName, preview, proxy, error, readError] {
+                if (preview.isNull()) {
+                    QMessageBox::warning(this, "Ошибка", error);
+                    return;
+                }
+                largeFileName = fileName;
+                largeFileError = readError;
+                originalImage = preview;
+                originalProxy = proxy;
+                originalHistogram = ImageHistogram();
+                processedHistogram = ImageHistogram();
+                processedImage = QImage();
+                processedProxy = QImage();
+                renderPending = false;
+                displayImages();
+            };
+        }
+
+        QImage img;
+        if (!img.load(fileName)) return [this, fileName] {
+            QMessageBox::warning(this, "Ошибка", QString("Не удалось загрузить изображение %1").arg(fileName));
+        };
+        img = img.convertToFormat(QImage::Format_RGB32);
+        const QImage proxy = makeProxy(img);
+        const ImageHistogram histogram = ImageHistogram::compute(img, ImageHistogram::kAllChannels, jobExecutor);
+        return [this, img, proxy, histogram] {
+            largeFileName.clear();
+            originalImage = img;
+            originalProxy = proxy;
+            originalHistogram = histogram;
+            processedHistogram = histogram;
+            processedImage = img;
+            processedProxy = proxy;
+            renderPending = false;
+            displayImages();
+        };
+    });
+}
+
+QImage MainWindow::makeProxy(const QImage &img)
+{
+    if (img.width() <= kProxySide && img.height() <= kProxySide) return img;
+    return img.scaled(kProxySide, kProxySide, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+void MainWindow::runJob(const std::function<std::function<void()>()> &work)
+{
+    if (jobControl) jobControl->cancel();
+    jobPool.clear();        // ждущее задание вытесняется новым
+
+    const std::shared_ptr<TaskControl> control = std::make_shared<TaskControl>();
+    const quint64 generation = ++jobGeneration;
+    jobControl = control;
+
+    progressBar->setRange(0, 0);
+    progressBar->show();
+    btnCancel->show();
+    progressTimer->start();
+
+    jobPool.start([this, work, control, generation] {
+        if (control->isCancelled()) return;
+        jobExecutor.setControl(control);
+        const std::function<void()> apply = work();
+        jobExecutor.setControl(nullptr);
+        if (control->isCancelled()) return;
+
+        QMetaObject::invokeMethod(this, [this, apply, generation] {
+            if (generation != jobGeneration) return;
+            finishJob();
+            apply();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::finishJob()
+{
+    jobControl.reset();
+    progressTimer->stop();
+    progressBar->hide();
+    btnCancel->hide();
+    setFiltersEnabled(true);
+    btnSave->setEnabled(true);
+}
+
+void MainWindow::cancelJob()
+{
+    if (!jobControl) return;
+    jobControl->cancel();
+    ++jobGeneration;
+    finishJob();
+    // Показывается последний готовый результат
+    renderPending = false;
+    displayImages();
+}
+
+void MainWindow::updateProgress()
+{
+    // До первых плиток (чтение файла) шкала остаётся бегущей
+    if (!jobControl || !jobControl->isStarted()) return;
+    progressBar->setRange(0, 100);
+    progressBar->setValue(jobControl->percent());
+}
+
+void MainWindow::setFiltersEnabled(bool enabled)
+{
+    btnLinear->setEnabled(enabled);
+    btnEqualize->setEnabled(enabled);
+    btnSharpen->setEnabled(enabled);
+}
+
+void MainWindow::startRender(const FilterPipeline &pipeline)
+{
+    previewProxy = pipeline.run(originalProxy);
+    renderPending = true;
+    btnSave->setEnabled(false);
+    displayImages();
+
+    const QImage source = originalImage;
+    runJob([this, pipeline, source]() -> std::function<void()> {
+        const QImage result = pipeline.run(source, jobExecutor);
+        const QImage proxy = makeProxy(result);
+        const ImageHistogram histogram = ImageHistogram::compute(result, ImageHistogram::bit(ImageHistogram::Luma), jobExecutor);
+        return [this, result, proxy, histogram] {
+            processedImage = result;
+            processedProxy = proxy;
+            processedHistogram = histogram;
+            renderPending = false;
+            displayImages();
+        };
+    });
+}
+
+void MainWindow::processLargeFile(const FilterPipeline &pipeline)
+{
+    if (!largeFileError.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", largeFileError);
+        return;
     }
+    QString outName = QFileDialog::getSaveFileName(this, "Сохранить результат", "", "PPM (*.ppm);;PAM (*.pam)");
+    if (outName.isEmpty()) return;
+
+    const QString input = largeFileName;
+    runJob([this, pipeline, input, outName]() -> std::function<void()> {
+        StripReader reader;
+        StripWriter writer;
+        QString error;
+        bool ok = reader.open(input, &error)
+                  && writer.open(outName, reader.size(), reader.hasAlpha(), &error)
+                  && pipeline.runStreamed(reader, writer, jobExecutor, &error)
+                  && writer.close(&error);
+        StripReader result;
+        QImage preview;
+        if (ok && result.open(outName, &error)) preview = result.preview(kPreviewSide, &error);
+        const QImage proxy = makeProxy(preview);
+        return [this, preview, proxy, error] {
+            if (preview.isNull()) {
+                QMessageBox::warning(this, "Ошибка", error);
+                return;
+            }
+            processedImage = preview;
+            processedProxy = proxy;
+            displayImages();
+        };
+    });
 }
 
 void MainWindow::saveImage()
 {
     if (processedImage.isNull()) return;
+    if (!largeFileName.isEmpty()) {
+        QMessageBox::information(this, "Сохранение", "Результат обработки большого файла уже записан на диск");
+        return;
+    }
     QString fileName = QFileDialog::getSaveFileName(this, "Сохранить изображение", "", "PNG (*.png);;JPEG (*.jpg *.jpeg);;BMP (*.bmp)");
     if (!fileName.isEmpty()) processedImage.save(fileName);
 }
 
 void MainWindow::applyLinearContrast() {
     if (originalImage.isNull()) return;
-    processedImage = ImageProcessor::linearContrast(originalImage);
-    displayImages();
+    if (!largeFileName.isEmpty()) return processLargeFile(FilterPipeline().linearContrast());
+    startRender(FilterPipeline().lut(ImageProcessor::linearContrastLut(originalHistogram)));
 }
 
 void MainWindow::applyEqualization() {
     if (originalImage.isNull()) return;
     QString mode = comboMode->currentText();
+    if (!largeFileName.isEmpty())
+        return processLargeFile(mode.startsWith("RGB") ? FilterPipeline().equalizeRGB() : FilterPipeline().equalizeHSV());
     if (mode.startsWith("RGB"))
-        processedImage = ImageProcessor::equalizeRGB(originalImage);
+        startRender(FilterPipeline().lut(ImageProcessor::equalizeRGBLut(originalHistogram)));
     else
-        processedImage = ImageProcessor::equalizeHSV(originalImage);
-    displayImages();
+        startRender(FilterPipeline().value(ImageProcessor::equalizeHSVLut(originalHistogram)));
 }
 
 void MainWindow::applySharpen() {
     if (originalImage.isNull()) return;
-    processedImage = ImageProcessor::sharpen(originalImage);
-    displayImages();
+    if (!largeFileName.isEmpty()) return processLargeFile(FilterPipeline().sharpen());
+    startRender(FilterPipeline().sharpen());
 }
 
-void MainWindow::displayImages()
+void MainWindow::resizeEvent(QResizeEvent *event)
 {
-    if (!originalImage.isNull()) {
-        labelOriginal->setPixmap(QPixmap::fromImage(originalImage).scaled(labelOriginal->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
-        labelHistOriginal->setPixmap(generateHistogram(originalImage));
-    } else {
-        labelOriginal->clear();
-        labelHistOriginal->clear();
-    }
-
-    if (!processedImage.isNull()) {
-        labelProcessed->setPixmap(QPixmap::fromImage(processedImage).scaled(labelProcessed->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
-        labelHistProcessed->setPixmap(generateHistogram(processedImage));
-    } else {
-        labelProcessed->clear();
-        labelHistProcessed->clear();
-    }
+    QMainWindow::resizeEvent(event);
+    displayImages();
 }
 
-QPixmap MainWindow::generateHistogram(const QImage &img)
+static void showCached(DisplayCache &cache, QLabel *image, QLabel *histogram)
 {
-    if (img.isNull()) return QPixmap();
-
-    QVector<int> hist(256, 0);
-    for (int y = 0; y < img.height(); ++y) {
-        const QRgb *line = reinterpret_cast<const QRgb*>(img.scanLine(y));
-        for (int x = 0; x < img.width(); ++x) {
-            int gray = qGray(line[x]);
-            hist[gray]++;
-        }
+    if (cache.isNull()) {
+        image->clear();
+        histogram->clear();
+        return;
     }
+    image->setPixmap(cache.pixmap(image->size()));
+    histogram->setPixmap(cache.histogramPixmap());
+}
 
-    int maxVal = *std::max_element(hist.begin(), hist.end());
-    if (maxVal == 0) maxVal = 1;
+void MainWindow::displayImages()
+{
+    // Кэши пересчитываются только для сменившегося изображения;
+    // пока полный результат считается, показывается копия и её гистограмма
+    originalDisplay.setImage(originalImage.isNull() ? QImage() : originalProxy, originalHistogram);
+    if (renderPending) processedDisplay.setImage(previewProxy);
+    else processedDisplay.setImage(processedProxy, processedHistogram);
 
-    QPixmap pix(256, 120);
-    pix.fill(Qt::white);
-    QPainter p(&pix);
-    p.setPen(Qt::black);
-    for (int i = 0; i < 256; ++i) {
-        int h = hist[i] * 100 / maxVal;
-        p.drawLine(i, 110, i, 110 - h);
-    }
-    p.drawRect(0, 0, pix.width()-1, pix.height()-1);
-    return pix;
+    showCached(originalDisplay, labelOriginal, labelHistOriginal);
+    showCached(processedDisplay, labelProcessed, labelHistProcessed);
 }
@@ -7,6 +7,17 @@
 #include <QPushButton>
 #include <QComboBox>
 #include <QPixmap>
+#include <QProgressBar>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+#include <memory>
+#include "displaycache.h"
+#include "imagehistogram.h"
+#include "tileexecutor.h"
+
+class FilterPipeline;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -15,16 +26,46 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+
 private slots:
     void loadImage();
     void saveImage();
     void applyLinearContrast();
     void applyEqualization();
     void applySharpen();
+    void cancelJob();
+    void updateProgress();
 
 private:
     QImage originalImage;
     QImage processedImage;
+    // Файл, слишком большой для загрузки: originalImage — его уменьшенная
+    // копия, фильтры обрабатывают файл полосами и пишут результат на диск
+    QString largeFileName;
+    QString largeFileError;     // не пусто — файл можно только смотреть (StripReader::canRead())
+
+    // Уменьшенные до экранного размера копии: фильтр сначала применяется к
+    // копии (previewProxy) и сразу показывается, полноразмерный результат
+    // считается в фоне и подменяет её по готовности
+    QImage originalProxy;
+    QImage processedProxy;                  // копия processedImage
+    QImage previewProxy;
+    ImageHistogram originalHistogram;       // статистика для таблиц — по полному изображению
+    ImageHistogram processedHistogram;      // пустая — гистограмма считается по копии
+    bool renderPending = false;
+    DisplayCache originalDisplay;
+    DisplayCache processedDisplay;
+
+    // Фоновые задания (загрузка, обработка) идут по одному. Новое задание
+    // отменяет текущее и вытесняет ждущее, так что после серии нажатий
+    // считается только последнее; отмена проверяется перед каждой плиткой
+    QThreadPool jobPool;
+    TileExecutor jobExecutor;
+    std::shared_ptr<TaskControl> jobControl;
+    quint64 jobGeneration = 0;              // номер последнего запущенного задания
+    QTimer *progressTimer;
 
     QLabel *labelOriginal;
     QLabel *labelProcessed;
@@ -36,12 +77,21 @@ private:
     QPushButton *btnLinear;
     QPushButton *btnEqualize;
     QPushButton *btnSharpen;
+    QPushButton *btnCancel;
+    QProgressBar *progressBar;
 
     QComboBox *comboMode;
 
     void setupUI();
     void displayImages();
-    QPixmap generateHistogram(const QImage &img);
+    void processLargeFile(const FilterPipeline &pipeline);
+    void startRender(const FilterPipeline &pipeline);
+    // work выполняется в jobPool и возвращает действие для потока интерфейса;
+    // действие отменённого или вытесненного задания не выполняется
+    void runJob(const std::function<std::function<void()>()> &work);
+    void finishJob();
+    void setFiltersEnabled(bool enabled);
+    static QImage makeProxy(const QImage &img);
 };
 
 #endif // MAINWINDOW_H
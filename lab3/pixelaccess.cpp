@@ -0,0 +1,12 @@
+#include "pixelaccess.h"
+
+QImage PixelAccess::toWorkingFormat(const QImage &img)
+{
+    if (img.format() == QImage::Format_RGB32 || img.format() == QImage::Format_ARGB32) return img;
+    return img.convertToFormat(img.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+}
+
+QImage PixelAccess::createLike(const QImage &src)
+{
+    return QImage(src.size(), src.format());
+}
@@ -0,0 +1,67 @@
+#ifndef PIXELACCESS_H
+#define PIXELACCESS_H
+
+#include <QImage>
+
+// Построчный доступ к пикселям 32-битных изображений (RGB32 / ARGB32).
+// Фильтры берут указатель на строку и читают QRgb напрямую, без
+// pixelColor()/setPixelColor(), которые на каждый пиксель проверяют
+// границы, переводят формат и создают QColor.
+namespace PixelAccess {
+
+// Формат, с которым работают фильтры: ARGB32, если есть альфа-канал, иначе RGB32
+QImage toWorkingFormat(const QImage &img);
+
+// Изображение того же размера и формата, пиксели не инициализированы
+QImage createLike(const QImage &src);
+
+class ConstRows {
+public:
+    explicit ConstRows(const QImage &img)
+        : m_bits(img.constBits()), m_stride(img.bytesPerLine()),
+          m_width(img.width()), m_height(img.height())
+    {
+        Q_ASSERT(img.depth() == 32);
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    const QRgb *row(int y) const { return reinterpret_cast<const QRgb *>(m_bits + y * m_stride); }
+
+private:
+    const uchar *m_bits;
+    qsizetype m_stride;
+    int m_width;
+    int m_height;
+};
+
+class Rows {
+public:
+    // img отсоединяется (bits()) один раз здесь, а не на каждой строке
+    explicit Rows(QImage &img)
+        : m_bits(img.bits()), m_stride(img.bytesPerLine()),
+          m_width(img.width()), m_height(img.height())
+    {
+        Q_ASSERT(img.depth() == 32);
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    QRgb *row(int y) const { return reinterpret_cast<QRgb *>(m_bits + y * m_stride); }
+
+private:
+    uchar *m_bits;
+    qsizetype m_stride;
+    int m_width;
+    int m_height;
+};
+
+// Новые цветовые компоненты с альфа-каналом исходного пикселя
+inline QRgb withRgb(QRgb pixel, int r, int g, int b)
+{
+    return qRgba(r, g, b, qAlpha(pixel));
+}
+
+} // namespace PixelAccess
+
+#endif // PIXELACCESS_H
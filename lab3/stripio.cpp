@@ -0,0 +1,364 @@
+#include "stripio.h"
+#include "pixelaccess.h"
+#include <QFileInfo>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QPixelFormat>
+#include <algorithm>
+
+using PixelAccess::ConstRows;
+using PixelAccess::Rows;
+
+namespace {
+
+// Полоса, которую preview() читает за раз
+constexpr qint64 kPreviewStripBytes = 32 * 1024 * 1024;
+// Полное изображение, которое preview() готов развернуть в памяти ради
+// уменьшенной копии, если декодер не умеет уменьшать сам
+constexpr qint64 kMaxPreviewDecodeBytes = 2048LL * 1024 * 1024;
+
+// Разбор заголовка PNM по словам с пропуском пробелов и комментариев
+class HeaderParser {
+public:
+    explicit HeaderParser(const QByteArray &data) : m_data(data) {}
+
+    int pos() const { return m_pos; }
+    bool atEnd() const { return m_pos >= m_data.size(); }
+
+    QByteArray word()
+    {
+        skipSpace();
+        const int start = m_pos;
+        while (!atEnd() && !isSpace(m_data[m_pos])) ++m_pos;
+        return m_data.mid(start, m_pos - start);
+    }
+
+    int number()
+    {
+        bool ok = false;
+        const int value = word().toInt(&ok);
+        return ok ? value : -1;
+    }
+
+    // Ровно один пробельный символ отделяет заголовок P5/P6 от данных
+    bool skipOneSpace()
+    {
+        if (atEnd() || !isSpace(m_data[m_pos])) return false;
+        ++m_pos;
+        return true;
+    }
+
+    QByteArray line()
+    {
+        const int end = m_data.indexOf('\n', m_pos);
+        if (end < 0) {
+            m_pos = m_data.size();
+            return QByteArray();
+        }
+        const QByteArray result = m_data.mid(m_pos, end - m_pos).trimmed();
+        m_pos = end + 1;
+        return result;
+    }
+
+private:
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    void skipSpace()
+    {
+        while (!atEnd()) {
+            if (m_data[m_pos] == '#') {
+                while (!atEnd() && m_data[m_pos] != '\n') ++m_pos;
+            } else if (isSpace(m_data[m_pos])) {
+                ++m_pos;
+            } else {
+                break;
+            }
+        }
+    }
+
+    const QByteArray &m_data;
+    int m_pos = 0;
+};
+
+bool isPnm(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "ppm" || suffix == "pgm" || suffix == "pnm" || suffix == "pam";
+}
+
+bool formatHasAlpha(QImage::Format format)
+{
+    return format != QImage::Format_Invalid
+        && QImage::toPixelFormat(format).alphaUsage() == QPixelFormat::UsesAlpha;
+}
+
+QString readerError(const QString &fileName, const QImageReader &reader)
+{
+    return QString("%1: %2").arg(fileName, reader.errorString());
+}
+
+} // namespace
+
+bool StripReader::open(const QString &fileName, QString *error)
+{
+    m_fileName = fileName;
+    m_whole = QImage();
+    m_file.close();
+
+    if (isPnm(fileName)) return openPnm(error);
+
+    QImageReader reader(fileName);
+    if (!reader.canRead()) {
+        *error = readerError(fileName, reader);
+        return false;
+    }
+    m_size = reader.size();
+    m_alpha = formatHasAlpha(reader.imageFormat());
+    const qint64 limit = qint64(QImageReader::allocationLimit()) * 1024 * 1024;
+    if (m_size.isValid() && limit > 0 && qint64(m_size.width()) * m_size.height() * 4 > limit) {
+        m_backend = PreviewOnly;
+        return true;
+    }
+
+    m_backend = Whole;
+    QImage img;
+    if (!reader.read(&img)) {
+        *error = readerError(fileName, reader);
+        return false;
+    }
+    m_whole = PixelAccess::toWorkingFormat(img);
+    m_size = m_whole.size();
+    m_alpha = m_whole.hasAlphaChannel();
+    return true;
+}
+
+bool StripReader::openPnm(QString *error)
+{
+    m_backend = Pnm;
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = m_file.errorString();
+        return false;
+    }
+
+    const QByteArray header = m_file.read(4096);
+    HeaderParser parser(header);
+    const QByteArray magic = parser.word();
+    int width = -1, height = -1, maxValue = -1;
+
+    if (magic == "P5" || magic == "P6") {
+        width = parser.number();
+        height = parser.number();
+        maxValue = parser.number();
+        m_channels = magic == "P5" ? 1 : 3;
+        if (!parser.skipOneSpace()) maxValue = -1;
+    } else if (magic == "P7") {
+        m_channels = 0;
+        while (!parser.atEnd()) {
+            const QByteArray line = parser.line();
+            if (line == "ENDHDR") break;
+            const QList<QByteArray> parts = line.split(' ');
+            if (parts.size() < 2) continue;
+            if (parts[0] == "WIDTH") width = parts[1].toInt();
+            else if (parts[0] == "HEIGHT") height = parts[1].toInt();
+            else if (parts[0] == "DEPTH") m_channels = parts[1].toInt();
+            else if (parts[0] == "MAXVAL") maxValue = parts[1].toInt();
+        }
+        if (m_channels < 1 || m_channels > 4) maxValue = -1;
+    }
+
+    if (width <= 0 || height <= 0 || maxValue != 255) {
+        *error = QString("%1: поддерживаются только двоичные PGM/PPM/PAM с 8 битами на канал").arg(m_fileName);
+        return false;
+    }
+
+    m_size = QSize(width, height);
+    m_alpha = m_channels == 2 || m_channels == 4;
+    m_dataOffset = parser.pos();
+    if (m_file.size() < m_dataOffset + qint64(width) * height * m_channels) {
+        *error = QString("%1: файл обрезан").arg(m_fileName);
+        return false;
+    }
+    return true;
+}
+
+QImage StripReader::read(int top, int count, QString *error)
+{
+    Q_ASSERT(top >= 0 && count > 0 && top + count <= m_size.height());
+
+    if (!canRead(error)) return QImage();
+    if (m_backend == Pnm) return readPnm(top, count, error);
+    return m_whole.copy(0, top, m_size.width(), count);
+}
+
+bool StripReader::canRead(QString *error) const
+{
+    if (m_backend != PreviewOnly) return true;
+    *error = QString("%1: этот формат не читается полосами, а целиком в память не помещается; "
+                     "для обработки по частям сохраните файл в PPM, PGM или PAM").arg(m_fileName);
+    return false;
+}
+
+QImage StripReader::readPnm(int top, int count, QString *error)
+{
+    const int w = m_size.width();
+    const qint64 lineBytes = qint64(w) * m_channels;
+    const QByteArray data = m_file.seek(m_dataOffset + top * lineBytes) ? m_file.read(count * lineBytes)
+                                                                         : QByteArray();
+    if (data.size() != count * lineBytes) {
+        *error = QString("%1: %2").arg(m_fileName, m_file.errorString());
+        return QImage();
+    }
+
+    QImage strip(w, count, m_alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    const Rows out(strip);
+    for (int y = 0; y < count; ++y) {
+        const uchar *src = reinterpret_cast<const uchar *>(data.constData()) + y * lineBytes;
+        QRgb *dst = out.row(y);
+        switch (m_channels) {
+        case 1:
+            for (int x = 0; x < w; ++x) dst[x] = qRgb(src[x], src[x], src[x]);
+            break;
+        case 2:
+            for (int x = 0; x < w; ++x, src += 2) dst[x] = qRgba(src[0], src[0], src[0], src[1]);
+            break;
+        case 3:
+            for (int x = 0; x < w; ++x, src += 3) dst[x] = qRgb(src[0], src[1], src[2]);
+            break;
+        default:
+            for (int x = 0; x < w; ++x, src += 4) dst[x] = qRgba(src[0], src[1], src[2], src[3]);
+            break;
+        }
+    }
+    return strip;
+}
+
+QImage StripReader::preview(int maxSide, QString *error)
+{
+    const QSize target = m_size.scaled(maxSide, maxSide, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+    if (m_backend == Whole) return m_whole.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    if (m_backend == PreviewOnly) {
+        // Декодеры с масштабированием (JPEG) уменьшают сразу при разборе,
+        // остальные разворачивают файл целиком и уменьшают потом
+        QImageReader reader(m_fileName);
+        const bool scalesWhileDecoding = reader.supportsOption(QImageIOHandler::ScaledSize);
+        const qint64 fullBytes = qint64(m_size.width()) * m_size.height() * 4;
+        if (!scalesWhileDecoding && fullBytes > kMaxPreviewDecodeBytes) {
+            *error = QString("%1: формат %2 декодируется только целиком (%3 МБ), такой файл не показать; "
+                             "сохраните его в PPM, PGM или PAM")
+                         .arg(m_fileName, QString::fromLatin1(reader.format()))
+                         .arg(fullBytes / (1024 * 1024));
+            return QImage();
+        }
+        reader.setScaledSize(target);
+
+        // Предел QImageReader проверяется по полному размеру, поэтому на время
+        // такого чтения он поднимается. Предел общий для процесса; открытие
+        // больших файлов в окне идёт по одному
+        const int limit = QImageReader::allocationLimit();
+        if (!scalesWhileDecoding && limit > 0)
+            QImageReader::setAllocationLimit(int(fullBytes / (1024 * 1024)) + 1);
+        QImage img;
+        const bool ok = reader.read(&img);
+        QImageReader::setAllocationLimit(limit);
+        if (!ok) {
+            *error = readerError(m_fileName, reader);
+            return QImage();
+        }
+        return PixelAccess::toWorkingFormat(img);
+    }
+
+    // Полоса источника [top, top + count) даёт строки [top·H'/H, (top + count)·H'/H) копии
+    QImage result(target, m_alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    const Rows out(result);
+    const int h = m_size.height();
+    const int stripRows = int(qBound<qint64>(1, kPreviewStripBytes / (qint64(m_size.width()) * 4), h));
+    for (int top = 0; top < h; top += stripRows) {
+        const int count = qMin(stripRows, h - top);
+        const int first = int(qint64(top) * target.height() / h);
+        const int last = int(qint64(top + count) * target.height() / h);
+        if (last <= first) continue;
+
+        const QImage strip = read(top, count, error);
+        if (strip.isNull()) return QImage();
+        const QImage scaled = strip.scaled(target.width(), last - first, Qt::IgnoreAspectRatio,
+                                           Qt::SmoothTransformation);
+        const ConstRows in(scaled);
+        for (int y = 0; y < in.height(); ++y)
+            std::copy(in.row(y), in.row(y) + in.width(), out.row(first + y));
+    }
+    return result;
+}
+
+bool StripWriter::supports(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "ppm" || suffix == "pnm" || suffix == "pam";
+}
+
+bool StripWriter::open(const QString &fileName, const QSize &size, bool alpha, QString *error)
+{
+    if (!supports(fileName)) {
+        *error = QString("%1: потоковая запись возможна только в PPM или PAM").arg(fileName);
+        return false;
+    }
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        *error = m_file.errorString();
+        return false;
+    }
+
+    m_size = size;
+    m_alpha = alpha;
+    m_written = 0;
+    const QByteArray header = alpha
+        ? QString("P7\nWIDTH %1\nHEIGHT %2\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n")
+              .arg(size.width()).arg(size.height()).toLatin1()
+        : QString("P6\n%1 %2\n255\n").arg(size.width()).arg(size.height()).toLatin1();
+    if (m_file.write(header) != header.size()) {
+        *error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool StripWriter::write(const QImage &strip, QString *error)
+{
+    Q_ASSERT(strip.width() == m_size.width() && m_written + strip.height() <= m_size.height());
+
+    const int channels = m_alpha ? 4 : 3;
+    const ConstRows in(strip);
+    m_buffer.resize(qsizetype(in.width()) * in.height() * channels);
+    uchar *dst = reinterpret_cast<uchar *>(m_buffer.data());
+    for (int y = 0; y < in.height(); ++y) {
+        const QRgb *src = in.row(y);
+        for (int x = 0; x < in.width(); ++x) {
+            *dst++ = uchar(qRed(src[x]));
+            *dst++ = uchar(qGreen(src[x]));
+            *dst++ = uchar(qBlue(src[x]));
+            if (m_alpha) *dst++ = uchar(qAlpha(src[x]));
+        }
+    }
+
+    if (m_file.write(m_buffer) != m_buffer.size()) {
+        *error = m_file.errorString();
+        return false;
+    }
+    m_written += in.height();
+    return true;
+}
+
+bool StripWriter::close(QString *error)
+{
+    if (m_written != m_size.height()) {
+        m_file.cancelWriting();
+        *error = QString("%1: записано %2 строк из %3").arg(m_file.fileName()).arg(m_written).arg(m_size.height());
+        return false;
+    }
+    if (!m_file.commit()) {
+        *error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
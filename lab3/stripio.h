@@ -0,0 +1,75 @@
+#ifndef STRIPIO_H
+#define STRIPIO_H
+
+#include <QFile>
+#include <QImage>
+#include <QSaveFile>
+#include <QString>
+
+// Чтение и запись изображения полосами строк, для файлов, которые целиком
+// в память не помещаются.
+//
+// PPM/PGM/PAM (8 бит на канал) читаются напрямую: полоса — это один
+// непрерывный участок файла. Остальные форматы QImageReader последовательно
+// по строкам не отдаёт (ClipRect заново декодирует файл с начала на каждую
+// полосу), поэтому они декодируются целиком один раз (isStreaming() == false),
+// если укладываются в QImageReader::allocationLimit(). Больший файл такого
+// формата можно только посмотреть (preview()), а read() отказывает с
+// предложением перевести его в PPM/PAM. JPEG для просмотра уменьшается прямо
+// при декодировании; PNG, BMP, TIFF и прочие декодируются целиком и потом
+// уменьшаются, поэтому их просмотр возможен, только пока полное изображение
+// не больше kMaxPreviewDecodeBytes, иначе preview() объясняет, почему нельзя.
+class StripReader {
+public:
+    bool open(const QString &fileName, QString *error);
+
+    QSize size() const { return m_size; }
+    bool hasAlpha() const { return m_alpha; }
+    bool isStreaming() const { return m_backend == Pnm; }
+    // false — файл можно только посмотреть; error объясняет почему
+    bool canRead(QString *error) const;
+
+    // Строки [top, top + count) в рабочем формате PixelAccess
+    QImage read(int top, int count, QString *error);
+
+    // Уменьшенная копия для показа: не больше maxSide по большей стороне
+    QImage preview(int maxSide, QString *error);
+
+private:
+    enum Backend { Pnm, Whole, PreviewOnly };
+
+    bool openPnm(QString *error);
+    QImage readPnm(int top, int count, QString *error);
+
+    QString m_fileName;
+    Backend m_backend = Whole;
+    QSize m_size;
+    bool m_alpha = false;
+
+    QFile m_file;               // Pnm
+    qint64 m_dataOffset = 0;
+    int m_channels = 0;         // 1 — серый, 3 — RGB, 4 — RGBA
+
+    QImage m_whole;             // Whole
+};
+
+// Последовательная запись полос в PPM (без альфа-канала) или PAM RGB_ALPHA.
+// Файл появляется под своим именем только после успешного close().
+class StripWriter {
+public:
+    static bool supports(const QString &fileName);       // .ppm, .pnm, .pam
+
+    bool open(const QString &fileName, const QSize &size, bool alpha, QString *error);
+    // Следующие strip.height() строк; strip в рабочем формате PixelAccess
+    bool write(const QImage &strip, QString *error);
+    bool close(QString *error);
+
+private:
+    QSaveFile m_file;
+    QSize m_size;
+    bool m_alpha = false;
+    int m_written = 0;
+    QByteArray m_buffer;
+};
+
+#endif // STRIPIO_H
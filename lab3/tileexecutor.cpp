@@ -0,0 +1,131 @@
+#include "tileexecutor.h"
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+
+namespace {
+
+void runTile(const Tile &tile, const std::function<void(const Tile &)> &fn, TaskControl *control)
+{
+    if (control && control->isCancelled()) return;
+    fn(tile);
+    if (control) control->tileDone();
+}
+
+// Общее состояние одного run(): помощники из пула могут стартовать уже
+// после того, как вызывающий поток всё доделал, поэтому живёт в shared_ptr
+struct Job {
+    QVector<Tile> tiles;
+    std::function<void(const Tile &)> fn;
+    std::shared_ptr<TaskControl> control;
+    std::atomic<int> next{0};
+    QMutex mutex;
+    QWaitCondition allDone;
+    int done = 0;
+
+    void work()
+    {
+        int finished = 0;
+        for (int i = next++; i < tiles.size(); i = next++) {
+            runTile(tiles[i], fn, control.get());
+            ++finished;
+        }
+        if (finished == 0) return;
+        QMutexLocker lock(&mutex);
+        done += finished;
+        if (done == tiles.size()) allDone.wakeAll();
+    }
+};
+
+} // namespace
+
+int TaskControl::percent()
+{
+    // Номер прохода читается раньше счётчиков: beginPass() сбрасывает их до
+    // смены номера, так что значение может лишь отстать, но не забежать вперёд
+    const int pass = m_pass;
+    const int passes = m_passes;
+    const qint64 total = m_total;
+    const double fraction = total > 0 ? qMin(1.0, double(m_done) / total) : 0.0;
+    const int value = int(100 * (qMin(pass, passes - 1) + fraction) / passes);
+    m_percent = qBound(m_percent, value, 100);
+    return m_percent;
+}
+
+TileExecutor::TileExecutor(int threads)
+{
+    setThreadCount(threads);
+}
+
+TileExecutor &TileExecutor::global()
+{
+    static TileExecutor executor;
+    return executor;
+}
+
+int TileExecutor::threadCount() const
+{
+    return m_threads;
+}
+
+void TileExecutor::setThreadCount(int threads)
+{
+    m_threads = threads > 0 ? threads : qMax(1, QThread::idealThreadCount());
+    // Один поток — вызывающий, остальные из пула
+    m_pool.setMaxThreadCount(qMax(1, m_threads - 1));
+}
+
+void TileExecutor::setControl(std::shared_ptr<TaskControl> control)
+{
+    m_control = std::move(control);
+}
+
+QVector<Tile> TileExecutor::bands(const QSize &size, int halo, int bandRows)
+{
+    return tiles(size, QSize(size.width(), qMax(1, bandRows)), halo);
+}
+
+QVector<Tile> TileExecutor::tiles(const QSize &size, const QSize &tileSize, int halo)
+{
+    QVector<Tile> result;
+    if (size.isEmpty()) return result;
+
+    const QRect bounds(QPoint(0, 0), size);
+    const int tw = qMax(1, tileSize.width());
+    const int th = qMax(1, tileSize.height());
+    for (int y = 0; y < size.height(); y += th) {
+        for (int x = 0; x < size.width(); x += tw) {
+            Tile tile;
+            tile.index = result.size();
+            tile.rect = QRect(x, y, qMin(tw, size.width() - x), qMin(th, size.height() - y));
+            tile.source = tile.rect.adjusted(-halo, -halo, halo, halo) & bounds;
+            result.append(tile);
+        }
+    }
+    return result;
+}
+
+void TileExecutor::run(const QVector<Tile> &tiles, const std::function<void(const Tile &)> &fn)
+{
+    if (tiles.isEmpty()) return;
+    if (m_control) m_control->addTiles(tiles.size());
+    if (m_threads == 1 || tiles.size() == 1) {
+        for (const Tile &tile : tiles) runTile(tile, fn, m_control.get());
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->tiles = tiles;
+    job->fn = fn;
+    job->control = m_control;
+
+    const int helpers = qMin(m_threads, int(tiles.size())) - 1;
+    for (int i = 0; i < helpers; ++i)
+        m_pool.start([job] { job->work(); });
+    job->work();
+
+    QMutexLocker lock(&job->mutex);
+    while (job->done < job->tiles.size()) job->allDone.wait(&job->mutex);
+}
@@ -0,0 +1,113 @@
+#ifndef TILEEXECUTOR_H
+#define TILEEXECUTOR_H
+
+#include <QRect>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Участок изображения, который обрабатывает одна задача
+struct Tile {
+    int index = 0;      // порядковый номер, не зависит от числа потоков
+    QRect rect;         // пиксели, которые задача пишет
+    QRect source;       // rect, расширенный на halo и обрезанный по изображению:
+                        // строки и столбцы, которые фильтр окрестности может читать
+};
+
+// Отмена и ход выполнения длинной операции. Исполнитель, которому задан
+// контроль (setControl), перед каждой плиткой проверяет отмену и пропускает
+// оставшиеся плитки, а после каждой увеличивает счётчик. Результат
+// отменённой операции не определён, его отбрасывают.
+class TaskControl {
+public:
+    void cancel() { m_cancelled = true; }
+    bool isCancelled() const { return m_cancelled; }
+
+    // Операция из count проходов: проход index занимает 1/count шкалы, его
+    // доля — плитки всех run() до следующего beginPass(). Без beginPass()
+    // вся операция считается одним проходом
+    void beginPass(int index, int count)
+    {
+        m_done = 0;
+        m_total = 0;
+        m_passes = qMax(1, count);
+        m_pass = index;
+    }
+    void addTiles(qint64 total)
+    {
+        m_total += total;
+        m_started = true;
+    }
+    void tileDone() { ++m_done; }
+
+    // Ход в процентах; не убывает, даже если проход добавил плитки по ходу
+    bool isStarted() const { return m_started; }
+    int percent();
+
+private:
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_started{false};
+    std::atomic<int> m_pass{0};
+    std::atomic<int> m_passes{1};
+    std::atomic<qint64> m_done{0};
+    std::atomic<qint64> m_total{0};
+    int m_percent = 0;      // percent() зовётся из одного потока
+};
+
+// Исполнитель фильтров по полосам или плиткам на пуле потоков.
+// Разбиение зависит только от размера изображения, каждая плитка пишет
+// только свои пиксели, а частичные результаты (гистограммы, минимумы)
+// сливаются в порядке номеров плиток, поэтому результат одинаков при
+// любом числе потоков. Вызывающий поток тоже берёт плитки, так что
+// вложенный вызов из задачи пула не блокируется.
+class TileExecutor {
+public:
+    static constexpr int kBandRows = 64;
+
+    explicit TileExecutor(int threads = 0);      // 0 — по числу ядер
+
+    static TileExecutor &global();
+
+    int threadCount() const;
+    void setThreadCount(int threads);
+
+    // Контроль для следующих run(); меняется только между ними
+    void setControl(std::shared_ptr<TaskControl> control);
+    void beginPass(int index, int count)
+    {
+        if (m_control) m_control->beginPass(index, count);
+    }
+    bool isCancelled() const { return m_control && m_control->isCancelled(); }
+
+    // Полосы во всю ширину по bandRows строк
+    static QVector<Tile> bands(const QSize &size, int halo = 0, int bandRows = kBandRows);
+    // Плитки tileSize построчно слева направо
+    static QVector<Tile> tiles(const QSize &size, const QSize &tileSize, int halo = 0);
+
+    void run(const QVector<Tile> &tiles, const std::function<void(const Tile &)> &fn);
+
+    void forEachBand(const QSize &size, int halo, const std::function<void(const Tile &)> &fn)
+    {
+        run(bands(size, halo), fn);
+    }
+
+    // map(tile) -> T для каждой плитки, затем reduce(acc, part) в порядке номеров
+    template <typename T, typename Map, typename Reduce>
+    T mapReduce(const QVector<Tile> &tiles, T init, Map map, Reduce reduce)
+    {
+        QVector<T> parts(tiles.size());
+        T *results = parts.data();
+        run(tiles, [&](const Tile &tile) { results[tile.index] = map(tile); });
+        for (const T &part : parts) reduce(init, part);
+        return init;
+    }
+
+private:
+    int m_threads;
+    QThreadPool m_pool;
+    std::shared_ptr<TaskControl> m_control;
+};
+
+#endif // TILEEXECUTOR_H
@@ -0,0 +1,149 @@
+#include "valuelut.h"
+#include "cpufeatures.h"
+#include "pixelaccess.h"
+#include "tileexecutor.h"
+#include <algorithm>
+
+#if defined(IMAGEPROCESSOR_X86)
+#  include <immintrin.h>
+#endif
+
+using PixelAccess::ConstRows;
+using PixelAccess::Rows;
+
+namespace {
+
+// c <= V, поэтому (c·scale + 2^15) >> 16 не превышает V' и в 8 бит помещается
+void scaleScalar(const quint32 *scale, const QRgb *src, QRgb *dst, int from, int count)
+{
+    for (int i = from; i < count; ++i) {
+        const QRgb p = src[i];
+        const quint32 m = scale[std::max({ qRed(p), qGreen(p), qBlue(p) })];
+        const quint32 r = (quint32(qRed(p)) * m + 0x8000) >> 16;
+        const quint32 g = (quint32(qGreen(p)) * m + 0x8000) >> 16;
+        const quint32 b = (quint32(qBlue(p)) * m + 0x8000) >> 16;
+        dst[i] = (p & 0xff000000u) | (r << 16) | (g << 8) | b;
+    }
+}
+
+#if defined(IMAGEPROCESSOR_X86)
+
+// Младшие 32 бита произведений по дорожкам: _mm_mullo_epi32 есть только с SSE4.1
+IMAGEPROCESSOR_TARGET("sse2")
+inline __m128i mulloSse2(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Без gather множители по четырём V берутся из таблицы обычными загрузками
+IMAGEPROCESSOR_TARGET("sse2")
+void scaleSse2(const quint32 *scale, const QRgb *src, QRgb *dst, int count)
+{
+    const __m128i byte = _mm_set1_epi32(0xff);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000u));
+    const __m128i half = _mm_set1_epi32(0x8000);
+    alignas(16) quint32 v[4];
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i r = _mm_and_si128(_mm_srli_epi32(x, 16), byte);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(x, 8), byte);
+        const __m128i b = _mm_and_si128(x, byte);
+        // Значения занимают младший байт дорожки, остальные байты нулевые
+        _mm_store_si128(reinterpret_cast<__m128i *>(v), _mm_max_epu8(r, _mm_max_epu8(g, b)));
+        const __m128i m = _mm_setr_epi32(int(scale[v[0]]), int(scale[v[1]]), int(scale[v[2]]), int(scale[v[3]]));
+
+        const __m128i r2 = _mm_srli_epi32(_mm_add_epi32(mulloSse2(r, m), half), 16);
+        const __m128i g2 = _mm_srli_epi32(_mm_add_epi32(mulloSse2(g, m), half), 16);
+        const __m128i b2 = _mm_srli_epi32(_mm_add_epi32(mulloSse2(b, m), half), 16);
+
+        __m128i out = _mm_or_si128(_mm_slli_epi32(r2, 16), _mm_slli_epi32(g2, 8));
+        out = _mm_or_si128(out, _mm_or_si128(b2, _mm_and_si128(x, alpha)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), out);
+    }
+    scaleScalar(scale, src, dst, i, count);
+}
+
+IMAGEPROCESSOR_TARGET("avx2")
+void scaleAvx2(const quint32 *scale, const QRgb *src, QRgb *dst, int count)
+{
+    const __m256i byte = _mm256_set1_epi32(0xff);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000u));
+    const __m256i half = _mm256_set1_epi32(0x8000);
+    const int *table = reinterpret_cast<const int *>(scale);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi32(x, 16), byte);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(x, 8), byte);
+        const __m256i b = _mm256_and_si256(x, byte);
+        const __m256i v = _mm256_max_epi32(r, _mm256_max_epi32(g, b));
+        const __m256i m = _mm256_i32gather_epi32(table, v, 4);
+
+        const __m256i r2 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(r, m), half), 16);
+        const __m256i g2 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(g, m), half), 16);
+        const __m256i b2 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(b, m), half), 16);
+
+        __m256i out = _mm256_or_si256(_mm256_slli_epi32(r2, 16), _mm256_slli_epi32(g2, 8));
+        out = _mm256_or_si256(out, _mm256_or_si256(b2, _mm256_and_si256(x, alpha)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+    }
+    scaleScalar(scale, src, dst, i, count);
+}
+
+#endif // IMAGEPROCESSOR_X86
+
+} // namespace
+
+ValueLut::ValueLut(const QVector<uchar> &values)
+{
+    Q_ASSERT(values.size() == 256);
+    m_scale[0] = 0;
+    for (int v = 0; v < 256; ++v) {
+        m_values[v] = values[v];
+        if (v > 0) m_scale[v] = (quint32(values[v]) * 65536 + quint32(v) / 2) / quint32(v);
+    }
+}
+
+void ValueLut::applyRow(const QRgb *src, QRgb *dst, int count) const
+{
+#if defined(IMAGEPROCESSOR_X86)
+    if (cpuFeatures().avx2) return scaleAvx2(m_scale, src, dst, count);
+    if (cpuFeatures().sse2) return scaleSse2(m_scale, src, dst, count);
+#endif
+    scaleScalar(m_scale, src, dst, 0, count);
+}
+
+QImage ValueLut::apply(const QImage &img) const
+{
+    return apply(img, TileExecutor::global());
+}
+
+QImage ValueLut::apply(const QImage &img, TileExecutor &executor) const
+{
+    if (img.isNull()) return img;
+
+    const QImage src = PixelAccess::toWorkingFormat(img);
+    QImage result = PixelAccess::createLike(src);
+    const ConstRows in(src);
+    const Rows out(result);
+    executor.forEachBand(src.size(), 0, [&](const Tile &band) {
+        for (int y = band.rect.top(); y <= band.rect.bottom(); ++y)
+            applyRow(in.row(y), out.row(y), in.width());
+    });
+    return result;
+}
+
+const char *ValueLut::isaName()
+{
+#if defined(IMAGEPROCESSOR_X86)
+    if (cpuFeatures().avx2) return "AVX2";
+    if (cpuFeatures().sse2) return "SSE2";
+#endif
+    return "scalar";
+}
@@ -0,0 +1,32 @@
+#ifndef VALUELUT_H
+#define VALUELUT_H
+
+#include <QImage>
+#include <QVector>
+
+class TileExecutor;
+
+// Точечная операция над яркостью V = max(R, G, B) модели HSV с сохранением
+// тона и насыщенности. При неизменных H и S компоненты RGB линейны по V,
+// поэтому новый пиксель — это старый, умноженный на V'/V: по таблице
+// множителей в фиксированной точке 16.16, без перевода в HSV и обратно.
+// Альфа-канал не меняется.
+class ValueLut {
+public:
+    explicit ValueLut(const QVector<uchar> &values);     // V -> V', 256 значений
+
+    uchar value(int v) const { return m_values[v]; }
+
+    // src и dst могут совпадать
+    void applyRow(const QRgb *src, QRgb *dst, int count) const;
+    QImage apply(const QImage &img) const;
+    QImage apply(const QImage &img, TileExecutor &executor) const;
+
+    static const char *isaName();
+
+private:
+    uchar m_values[256];
+    quint32 m_scale[256];       // round(V' / V * 2^16), для V = 0 — 0
+};
+
+#endif // VALUELUT_H